@@ -0,0 +1,307 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+/*
+ Throughput benchmarks over the bundled test containers and example programs,
+ plus a generated multi-megabyte program. Run from the repository root:
+ 
+   bench [--baseline <file>] [--save <file>] [--tolerance <fraction>]
+ 
+ With --baseline, any benchmark slower than the stored figure by more than
+ the tolerance (default 0.25) is reported and the exit status is non-zero.
+ The batch benchmarks go through the file system, whose page cache and
+ writeback swing them far more than the in-memory ones, so they are run
+ for longer and allowed BatchTolerance (at least) instead.
+ */
+
+#include "hpprgm.hpp"
+#include "utf.hpp"
+#include "io.hpp"
+#include "batch.hpp"
+#include "minify.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <vector>
+#include <sys/resource.h>
+
+namespace fs = std::filesystem;
+
+// MARK: - Allocation Counting
+
+static std::atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+static double peakRSS() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1e6;
+#else
+    return usage.ru_maxrss / 1e3;
+#endif
+}
+
+// MARK: - Corpus
+
+static std::vector<std::byte> readFile(const fs::path& path) {
+    io::MappedFile file;
+    if (!file.open(path)) return {};
+    return std::vector<std::byte>(file.bytes().begin(), file.bytes().end());
+}
+
+static std::vector<std::vector<std::byte>> readFiles(const fs::path& dir, const std::string& extension) {
+    std::vector<std::vector<std::byte>> files;
+    std::error_code ec;
+    
+    for (const auto& entry : fs::directory_iterator(dir, ec)) {
+        if (entry.path().extension() != extension && !(extension == ".hpprgm" && entry.path().extension() == ".hpappprgm")) continue;
+        files.push_back(readFile(entry.path()));
+    }
+    return files;
+}
+
+// Repeats the example programs until the text is at least size code units.
+static std::u16string generateProgram(size_t size) {
+    std::vector<std::u16string> sources;
+    std::u16string str;
+    
+    for (const auto& entry : fs::recursive_directory_iterator("examples")) {
+        if (entry.path().extension() != ".prgm") continue;
+        sources.push_back(hpprgm::load(entry.path()));
+    }
+    if (sources.empty()) sources.push_back(u"EXPORT Main()\nBEGIN\n  LOCAL a := 0;\n  PRINT(\"→ ∑ π\");\nEND;\n");
+    
+    while (str.size() < size) {
+        for (const auto& source : sources) str += source;
+    }
+    
+    // Containers and files never hold CRs, so the writers have none to drop.
+    std::erase(str, u'\r');
+    return str;
+}
+
+// MARK: - Benchmarks
+
+struct Measurement {
+    double mbps;
+    double allocations;
+};
+
+static constexpr double BatchTolerance = 0.6;
+
+/*
+ Runs fn in batches of at least 50ms (5 unless asked for more) and keeps
+ the fastest batch, which is the least disturbed by whatever else the
+ machine is doing.
+ */
+static Measurement measure(size_t bytes, const std::function<void()>& fn, int batches = 5) {
+    using clock = std::chrono::steady_clock;
+    double best = 0;
+    size_t iterations = 0;
+    size_t allocated = allocations.load();
+    
+    fn();
+    for (int batch = 0; batch < batches; ++batch) {
+        auto start = clock::now();
+        size_t count = 0;
+        std::chrono::duration<double> elapsed;
+        
+        do {
+            fn();
+            count++;
+            elapsed = clock::now() - start;
+        } while (elapsed.count() < 0.05);
+        
+        iterations += count;
+        best = std::max(best, bytes * count / elapsed.count() / 1e6);
+    }
+    
+    return {best, double(allocations.load() - allocated) / double(iterations + 1)};
+}
+
+static std::map<std::string, double> readBaseline(const fs::path& path) {
+    std::map<std::string, double> baseline;
+    std::ifstream is(path);
+    std::string name;
+    double mbps;
+    
+    while (is >> name >> mbps) baseline[name] = mbps;
+    return baseline;
+}
+
+int main(int argc, const char* argv[]) {
+    fs::path baselinePath, savePath;
+    double tolerance = 0.25;
+    
+    for (int n = 1; n < argc; ++n) {
+        std::string args(argv[n]);
+        if (args == "--baseline" && n + 1 < argc) baselinePath = argv[++n];
+        else if (args == "--save" && n + 1 < argc) savePath = argv[++n];
+        else if (args == "--tolerance" && n + 1 < argc) tolerance = std::atof(argv[++n]);
+        else {
+            std::cerr << "Usage: bench [--baseline <file>] [--save <file>] [--tolerance <fraction>]\n";
+            return 1;
+        }
+    }
+    
+    auto containers = readFiles("test", ".hpprgm");
+    auto fonts = readFiles("examples/fonts", ".prgm");
+    
+    std::u16string program = generateProgram(4 * 1024 * 1024);
+    std::string programUTF8 = utf::utf8(program);
+    std::vector<std::byte> programG1, programG2;
+    hpprgm::save(programG1, program, hpprgm::G1);
+    hpprgm::save(programG2, program, hpprgm::G2);
+    
+    size_t containerBytes = 0, fontBytes = 0;
+    for (const auto& file : containers) containerBytes += file.size();
+    for (const auto& file : fonts) fontBytes += file.size();
+    
+    std::string utf8;
+    std::vector<std::byte> out;
+    fs::path scratch = fs::temp_directory_path() / "hpprgm-bench.hpprgm";
+    std::ofstream devnull("/dev/null", std::ios::binary);
+    
+    // Many small programs, converted as a batch with each I/O backend.
+    fs::path corpus = fs::temp_directory_path() / "hpprgm-bench";
+    std::vector<batch::Job> jobs;
+    size_t corpusBytes = 0;
+    fs::create_directories(corpus / "in");
+    fs::create_directories(corpus / "out");
+    for (size_t i = 0; i < 1024 && !containers.empty(); ++i) {
+        const auto& file = containers[i % containers.size()];
+        fs::path inpath = corpus / "in" / ("P" + std::to_string(i) + ".hpprgm");
+        io::write(inpath, {file});
+        jobs.push_back({inpath, corpus / "out" / ("P" + std::to_string(i) + ".prgm")});
+        corpusBytes += file.size();
+    }
+    
+    std::vector<std::pair<std::string, Measurement>> results = {
+        {"detect", measure(containerBytes, [&] {
+            for (const auto& file : containers) {
+                volatile size_t size = hpprgm::code(file).size();
+                (void)size;
+            }
+        })},
+        {"extract/test", measure(containerBytes, [&] {
+            for (const auto& file : containers) (void)hpprgm::load(file);
+        })},
+        {"extract/G1", measure(programG1.size(), [&] { (void)hpprgm::load(programG1); })},
+        {"extract/G2", measure(programG2.size(), [&] { (void)hpprgm::load(programG2); })},
+        {"read/fonts", measure(fontBytes, [&] {
+            for (const auto& file : fonts) (void)utf::read(file, utf::BOMle);
+        })},
+        {"utf8", measure(program.size() * 2, [&] { utf::utf8(program, utf8); })},
+        {"utf16", measure(programUTF8.size(), [&] { (void)utf::utf16(programUTF8); })},
+        {"minify", measure(program.size() * 2, [&] { (void)minify::code(program, true); })},
+        {"write", measure(program.size() * 2, [&] {
+            devnull.seekp(0);
+            utf::write(devnull, program, utf::BOMle);
+        })},
+        {"save/G1", measure(program.size() * 2, [&] {
+            out.clear();
+            hpprgm::save(out, program, hpprgm::G1);
+        })},
+        {"save/G2", measure(program.size() * 2, [&] {
+            out.clear();
+            hpprgm::save(out, program, hpprgm::G2);
+        })},
+        {"save/file", measure(program.size() * 2, [&] { hpprgm::save(scratch, program); })},
+        {"batch/blocking", measure(corpusBytes, [&] { batch::run(jobs, 4, nullptr, aio::Backend::Blocking); }, 20)}
+    };
+    if (aio::available(aio::Backend::Uring)) {
+        results.push_back({"batch/uring", measure(corpusBytes, [&] { batch::run(jobs, 4, nullptr, aio::Backend::Uring); }, 20)});
+    }
+    fs::remove(scratch);
+    fs::remove_all(corpus);
+    
+    auto baseline = readBaseline(baselinePath);
+    int regressions = 0;
+    
+    std::cout << std::left << std::setw(16) << "benchmark" << std::right
+              << std::setw(12) << "MB/s" << std::setw(12) << "baseline" << std::setw(12) << "allocs/op" << "\n";
+    for (const auto& [name, result] : results) {
+        std::cout << std::left << std::setw(16) << name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(12) << result.mbps;
+        if (baseline.contains(name)) {
+            std::cout << std::setw(12) << baseline[name];
+        } else {
+            std::cout << std::setw(12) << "-";
+        }
+        std::cout << std::setw(12) << result.allocations;
+        double allowed = name.starts_with("batch/") ? std::max(tolerance, BatchTolerance) : tolerance;
+        if (baseline.contains(name) && result.mbps < baseline[name] * (1.0 - allowed)) {
+            std::cout << "  REGRESSION";
+            regressions++;
+        }
+        std::cout << "\n";
+    }
+    std::cout << "peak RSS " << std::setprecision(1) << peakRSS() << " MB\n";
+    
+    if (!savePath.empty()) {
+        std::ofstream os(savePath);
+        for (const auto& [name, result] : results) {
+            os << name << " " << std::fixed << std::setprecision(1) << result.mbps << "\n";
+        }
+    }
+    
+    if (regressions) {
+        std::cout << regressions << " benchmark(s) below baseline by more than their tolerance.\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,590 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "aio.hpp"
+#include "io.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#if defined(__linux__) && __has_include(<linux/io_uring.h>)
+#define AIO_URING
+#include <linux/io_uring.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace aio;
+
+std::optional<Backend> aio::backend(std::string_view name) {
+    if (name == "blocking") return Backend::Blocking;
+    if (name == "uring") return Backend::Uring;
+    return std::nullopt;
+}
+
+std::string_view aio::describe(Backend backend) {
+    switch (backend) {
+        case Backend::Blocking: return "blocking";
+        case Backend::Uring: return "uring";
+    }
+    return "";
+}
+
+#ifdef AIO_URING
+
+// MARK: - Ring
+
+namespace {
+    /*
+     Just enough of io_uring, driven through the raw system calls so there is
+     no dependency on liburing. Only the thread that owns a ring may use it.
+     */
+    class Ring {
+    public:
+        Ring() = default;
+        ~Ring();
+        
+        Ring(const Ring&) = delete;
+        Ring& operator=(const Ring&) = delete;
+        
+        bool open(unsigned entries);
+        
+        void openat(const char* path, int flags, mode_t mode, uint64_t tag);
+        void read(int fd, std::byte* buffer, size_t size, uint64_t offset, uint64_t tag);
+        void write(int fd, const std::byte* buffer, size_t size, uint64_t offset, uint64_t tag);
+        void close(int fd, uint64_t tag);
+        void statx(const char* path, int flags, unsigned mask, struct statx* buffer, uint64_t tag);
+        void renameat(const char* from, const char* to, uint64_t tag);
+        
+        // Submits everything queued, then waits for at least one completion.
+        bool wait();
+        bool next(uint64_t& tag, int& result);
+        
+    private:
+        io_uring_sqe* queue(uint8_t opcode, int fd, uint64_t tag);
+        
+        int fd_ = -1;
+        void* sq_ = MAP_FAILED;
+        void* cq_ = MAP_FAILED;
+        void* sqes_ = MAP_FAILED;
+        size_t sqSize_ = 0;
+        size_t cqSize_ = 0;
+        size_t sqesSize_ = 0;
+        
+        unsigned* sqTail_ = nullptr;
+        unsigned* sqArray_ = nullptr;
+        unsigned sqMask_ = 0;
+        unsigned* cqHead_ = nullptr;
+        unsigned* cqTail_ = nullptr;
+        unsigned cqMask_ = 0;
+        io_uring_cqe* cqes_ = nullptr;
+        
+        unsigned tail_ = 0;
+        unsigned queued_ = 0;
+    };
+}
+
+// Single reads and writes are capped well below the 32-bit length field.
+static constexpr size_t MaxTransfer = size_t(1) << 30;
+
+Ring::~Ring() {
+    if (sqes_ != MAP_FAILED) munmap(sqes_, sqesSize_);
+    if (cq_ != MAP_FAILED && cq_ != sq_) munmap(cq_, cqSize_);
+    if (sq_ != MAP_FAILED) munmap(sq_, sqSize_);
+    if (fd_ >= 0) ::close(fd_);
+}
+
+bool Ring::open(unsigned entries) {
+    io_uring_params params{};
+    
+    fd_ = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+    if (fd_ < 0) return false;
+    
+    /*
+     OPENAT, READ, WRITE, CLOSE and STATX all arrived in Linux 5.6, as did
+     this flag. RENAMEAT came in 5.11; before that it fails with EINVAL and
+     the pipeline falls back to rename(2).
+     */
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) return false;
+    
+    sqSize_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqSize_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single) sqSize_ = cqSize_ = std::max(sqSize_, cqSize_);
+    
+    sq_ = mmap(nullptr, sqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQ_RING);
+    if (sq_ == MAP_FAILED) return false;
+    
+    cq_ = single ? sq_ : mmap(nullptr, cqSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_CQ_RING);
+    if (cq_ == MAP_FAILED) return false;
+    
+    sqesSize_ = params.sq_entries * sizeof(io_uring_sqe);
+    sqes_ = mmap(nullptr, sqesSize_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, IORING_OFF_SQES);
+    if (sqes_ == MAP_FAILED) return false;
+    
+    auto* sq = static_cast<std::byte*>(sq_);
+    auto* cq = static_cast<std::byte*>(cq_);
+    sqTail_ = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqArray_ = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    sqMask_ = *reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    cqHead_ = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail_ = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask_ = *reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes_ = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    tail_ = *sqTail_;
+    return true;
+}
+
+io_uring_sqe* Ring::queue(uint8_t opcode, int fd, uint64_t tag) {
+    unsigned index = tail_++ & sqMask_;
+    io_uring_sqe* sqe = static_cast<io_uring_sqe*>(sqes_) + index;
+    
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->user_data = tag;
+    sqArray_[index] = index;
+    queued_++;
+    return sqe;
+}
+
+void Ring::openat(const char* path, int flags, mode_t mode, uint64_t tag) {
+    io_uring_sqe* sqe = queue(IORING_OP_OPENAT, AT_FDCWD, tag);
+    sqe->addr = reinterpret_cast<uintptr_t>(path);
+    sqe->len = mode;
+    sqe->open_flags = static_cast<uint32_t>(flags);
+}
+
+void Ring::read(int fd, std::byte* buffer, size_t size, uint64_t offset, uint64_t tag) {
+    io_uring_sqe* sqe = queue(IORING_OP_READ, fd, tag);
+    sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+    sqe->len = static_cast<uint32_t>(std::min(size, MaxTransfer));
+    sqe->off = offset;
+}
+
+void Ring::write(int fd, const std::byte* buffer, size_t size, uint64_t offset, uint64_t tag) {
+    io_uring_sqe* sqe = queue(IORING_OP_WRITE, fd, tag);
+    sqe->addr = reinterpret_cast<uintptr_t>(buffer);
+    sqe->len = static_cast<uint32_t>(std::min(size, MaxTransfer));
+    sqe->off = offset;
+}
+
+void Ring::close(int fd, uint64_t tag) {
+    queue(IORING_OP_CLOSE, fd, tag);
+}
+
+void Ring::statx(const char* path, int flags, unsigned mask, struct statx* buffer, uint64_t tag) {
+    io_uring_sqe* sqe = queue(IORING_OP_STATX, AT_FDCWD, tag);
+    sqe->addr = reinterpret_cast<uintptr_t>(path);
+    sqe->len = mask;
+    sqe->off = reinterpret_cast<uintptr_t>(buffer);
+    sqe->statx_flags = static_cast<uint32_t>(flags);
+}
+
+void Ring::renameat(const char* from, const char* to, uint64_t tag) {
+    io_uring_sqe* sqe = queue(IORING_OP_RENAMEAT, AT_FDCWD, tag);
+    sqe->addr = reinterpret_cast<uintptr_t>(from);
+    sqe->len = static_cast<uint32_t>(AT_FDCWD);
+    sqe->addr2 = reinterpret_cast<uintptr_t>(to);
+}
+
+bool Ring::wait() {
+    std::atomic_ref<unsigned>(*sqTail_).store(tail_, std::memory_order_release);
+    
+    while (true) {
+        long n = syscall(__NR_io_uring_enter, fd_, queued_, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+        if (n >= 0) {
+            queued_ -= std::min<unsigned>(queued_, static_cast<unsigned>(n));
+            return true;
+        }
+        if (errno != EINTR) return false;
+    }
+}
+
+bool Ring::next(uint64_t& tag, int& result) {
+    unsigned head = *cqHead_;
+    if (head == std::atomic_ref<unsigned>(*cqTail_).load(std::memory_order_acquire)) return false;
+    
+    const io_uring_cqe& cqe = cqes_[head & cqMask_];
+    tag = cqe.user_data;
+    result = cqe.res;
+    std::atomic_ref<unsigned>(*cqHead_).store(head + 1, std::memory_order_release);
+    return true;
+}
+
+bool aio::available(Backend backend) {
+    if (backend == Backend::Blocking) return true;
+    
+    static const bool uring = [] {
+        Ring ring;
+        return ring.open(2);
+    }();
+    return uring;
+}
+
+// MARK: - Pipeline
+
+namespace {
+    enum Stage {
+        Opening,
+        Reading,
+        ClosingInput,
+        Converting,
+        Inspecting,
+        Creating,
+        Writing,
+        ClosingOutput,
+        Renaming,
+        Done
+    };
+    
+    /*
+     Everything about one transfer while it is in flight. Each has at most
+     one operation on the ring at a time, tagged with its index. While it
+     is Converting only the worker converting it touches it.
+     */
+    struct File {
+        Stage stage = Opening;
+        std::string path;
+        std::string temporary;
+        std::string outpath;
+        struct statx target;
+        int fd = -1;
+        bool regular = true;
+        bool replace = false;
+        mode_t mode = 0;
+        std::vector<std::byte> data;
+        size_t done = 0;
+        Status status = Status::Converted;
+    };
+    
+    class Pipeline {
+    public:
+        Pipeline(const std::vector<Transfer>& transfers, unsigned threads, const Transform& transform, const Finished& finished)
+            : transfers_(transfers), files_(transfers.size()), transform_(transform), finished_(finished), pool_(threads) {}
+        
+        ~Pipeline() {
+            if (event_ >= 0) ::close(event_);
+        }
+        
+        bool open(unsigned depth);
+        void run();
+        
+    private:
+        static constexpr uint64_t EventTag = ~uint64_t(0);
+        
+        void start(size_t index);
+        void complete(size_t index, int result);
+        void read(size_t index);
+        void convert(size_t index);
+        void inspect(size_t index);
+        void create(size_t index, bool exists);
+        void write(size_t index);
+        void rename(size_t index);
+        void finish(size_t index, Status status);
+        void converted();
+        
+        const std::vector<Transfer>& transfers_;
+        std::vector<File> files_;
+        const Transform& transform_;
+        const Finished& finished_;
+        
+        Ring ring_;
+        unsigned depth_ = 0;
+        size_t next_ = 0;
+        size_t inflight_ = 0;
+        size_t completed_ = 0;
+        
+        // Workers hand back converted files through an eventfd read kept on the ring.
+        int event_ = -1;
+        uint64_t counter_ = 0;
+        std::mutex mutex_;
+        std::vector<std::pair<size_t, bool>> ready_;
+        
+        ThreadPool pool_;
+    };
+}
+
+bool Pipeline::open(unsigned depth) {
+    depth_ = std::max(1u, depth);
+    event_ = eventfd(0, EFD_CLOEXEC);
+    if (event_ < 0) return false;
+    
+    // Every transfer has at most one operation outstanding, plus the eventfd read.
+    return ring_.open(depth_ + 1);
+}
+
+void Pipeline::run() {
+    ring_.read(event_, reinterpret_cast<std::byte*>(&counter_), sizeof(counter_), 0, EventTag);
+    
+    while (completed_ < files_.size()) {
+        while (next_ < files_.size() && inflight_ < depth_) start(next_++);
+        
+        if (!ring_.wait()) break;
+        
+        uint64_t tag;
+        int result;
+        while (ring_.next(tag, result)) {
+            if (tag == EventTag) {
+                ring_.read(event_, reinterpret_cast<std::byte*>(&counter_), sizeof(counter_), 0, EventTag);
+                converted();
+                continue;
+            }
+            complete(static_cast<size_t>(tag), result);
+        }
+    }
+    
+    // Only reached early if the ring itself fails; wait for any conversions still running.
+    pool_.wait();
+    converted();
+    for (size_t i = 0; i < files_.size(); ++i) {
+        if (files_[i].stage != Done && files_[i].fd >= 0) ::close(files_[i].fd);
+    }
+}
+
+void Pipeline::start(size_t index) {
+    File& file = files_[index];
+    
+    inflight_++;
+    file.path = transfers_[index].inpath.string();
+    ring_.openat(file.path.c_str(), O_RDONLY | O_CLOEXEC, 0, index);
+}
+
+void Pipeline::complete(size_t index, int result) {
+    File& file = files_[index];
+    
+    switch (file.stage) {
+        case Opening: {
+            if (result < 0) return finish(index, Status::Unreadable);
+            file.fd = result;
+            
+            // Pipes and devices have no size up front, so grow the buffer as we go.
+            struct stat st;
+            file.regular = fstat(file.fd, &st) == 0 && S_ISREG(st.st_mode);
+            file.data.resize(file.regular ? static_cast<size_t>(st.st_size) : 65536);
+            file.done = 0;
+            file.stage = Reading;
+            return read(index);
+        }
+            
+        case Reading:
+            if (result < 0) file.status = Status::Unreadable;
+            if (result <= 0) {
+                file.data.resize(file.done);
+            } else {
+                file.done += static_cast<size_t>(result);
+                if (!file.regular && file.done == file.data.size()) file.data.resize(file.data.size() * 2);
+            }
+            return read(index);
+            
+        case ClosingInput:
+            file.fd = -1;
+            if (file.status != Status::Converted) return finish(index, file.status);
+            return convert(index);
+            
+        case Inspecting:
+            return create(index, result == 0);
+            
+        case Creating:
+            if (result < 0) return finish(index, Status::Unwritable);
+            file.fd = result;
+            
+            // Keep the permissions of the file being replaced.
+            if (file.replace) fchmod(file.fd, file.mode);
+            file.done = 0;
+            file.stage = Writing;
+            return write(index);
+            
+        case Writing:
+            if (result <= 0) {
+                file.status = Status::Unwritable;
+                file.done = file.data.size();
+            } else {
+                file.done += static_cast<size_t>(result);
+            }
+            return write(index);
+            
+        case ClosingOutput:
+            file.fd = -1;
+            if (result < 0) file.status = Status::Unwritable;
+            return rename(index);
+            
+        case Renaming:
+            // Kernels before 5.11 do not know the opcode.
+            if (result == -EINVAL) result = ::rename(file.temporary.c_str(), file.outpath.c_str()) == 0 ? 0 : -errno;
+            if (result == 0) return finish(index, Status::Converted);
+            ::unlink(file.temporary.c_str());
+            return finish(index, Status::Unwritable);
+            
+        case Converting:
+        case Done:
+            return;
+    }
+}
+
+void Pipeline::read(size_t index) {
+    File& file = files_[index];
+    
+    if (file.status == Status::Converted && file.done < file.data.size()) {
+        ring_.read(file.fd, file.data.data() + file.done, file.data.size() - file.done, file.done, index);
+        return;
+    }
+    
+    file.data.resize(file.done);
+    file.stage = ClosingInput;
+    ring_.close(file.fd, index);
+}
+
+void Pipeline::convert(size_t index) {
+    files_[index].stage = Converting;
+    
+    pool_.submit([this, index] {
+        File& file = files_[index];
+        std::vector<std::byte> output;
+        bool success;
+        
+        // An exception here would end the worker thread, and with it the batch.
+        try {
+            success = transform_(index, file.data, output);
+        } catch (const std::exception&) {
+            success = false;
+            output.clear();
+        }
+        file.data = std::move(output);
+        
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ready_.push_back({index, success});
+        }
+        uint64_t one = 1;
+        while (::write(event_, &one, sizeof(one)) < 0 && errno == EINTR) {}
+    });
+}
+
+void Pipeline::converted() {
+    std::vector<std::pair<size_t, bool>> ready;
+    
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ready.swap(ready_);
+    }
+    
+    for (auto [index, success] : ready) {
+        if (!success) {
+            finish(index, Status::Failed);
+            continue;
+        }
+        inspect(index);
+    }
+}
+
+void Pipeline::inspect(size_t index) {
+    File& file = files_[index];
+    
+    file.outpath = transfers_[index].outpath.string();
+    file.stage = Inspecting;
+    ring_.statx(file.outpath.c_str(), AT_SYMLINK_NOFOLLOW, STATX_TYPE | STATX_MODE, &file.target, index);
+}
+
+void Pipeline::create(size_t index, bool exists) {
+    File& file = files_[index];
+    const std::filesystem::path& outpath = transfers_[index].outpath;
+    
+    /*
+     As with io::write, pipes, devices and symbolic links are written in
+     place, which is rare enough to do there and then.
+     */
+    if (exists && !S_ISREG(file.target.stx_mode)) {
+        return finish(index, io::write(outpath, {file.data}) ? Status::Converted : Status::Unwritable);
+    }
+    
+    file.replace = exists;
+    file.mode = exists ? file.target.stx_mode & 07777 : 0644;
+    file.temporary = io::temporary(outpath).string();
+    file.stage = Creating;
+    ring_.openat(file.temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644, index);
+}
+
+void Pipeline::write(size_t index) {
+    File& file = files_[index];
+    
+    if (file.done < file.data.size()) {
+        ring_.write(file.fd, file.data.data() + file.done, file.data.size() - file.done, file.done, index);
+        return;
+    }
+    
+    file.stage = ClosingOutput;
+    ring_.close(file.fd, index);
+}
+
+void Pipeline::rename(size_t index) {
+    File& file = files_[index];
+    
+    // Failures are rare enough to clean up there and then.
+    if (file.status != Status::Converted) {
+        ::unlink(file.temporary.c_str());
+        return finish(index, Status::Unwritable);
+    }
+    file.stage = Renaming;
+    ring_.renameat(file.temporary.c_str(), file.outpath.c_str(), index);
+}
+
+void Pipeline::finish(size_t index, Status status) {
+    files_[index] = File{};
+    files_[index].stage = Done;
+    inflight_--;
+    completed_++;
+    finished_(index, status);
+}
+
+bool aio::run(const std::vector<Transfer>& transfers, unsigned threads, const Transform& transform, const Finished& finished, unsigned depth) {
+    if (!available(Backend::Uring)) return false;
+    
+    Pipeline pipeline(transfers, threads, transform, finished);
+    if (!pipeline.open(depth)) return false;
+    
+    pipeline.run();
+    return true;
+}
+
+#else
+
+bool aio::available(Backend backend) {
+    return backend == Backend::Blocking;
+}
+
+bool aio::run(const std::vector<Transfer>&, unsigned, const Transform&, const Finished&, unsigned) {
+    return false;
+}
+
+#endif
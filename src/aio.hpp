@@ -0,0 +1,90 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef aio_hpp
+#define aio_hpp
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <optional>
+#include <functional>
+#include <filesystem>
+#include <string_view>
+
+namespace aio {
+    /**
+     How batch conversion does its file I/O. Blocking has each worker thread
+     open, read, convert and write one file at a time. Uring keeps many reads
+     and writes in flight on an io_uring, from a single thread, while the
+     workers only convert.
+     */
+    enum class Backend {
+        Blocking,
+        Uring
+    };
+    
+    std::optional<Backend> backend(std::string_view name);
+    std::string_view describe(Backend backend);
+    
+    /**
+     Whether the backend can be used on this system. io_uring needs Linux 5.6
+     or later, and may also be disabled by the kernel or a seccomp policy.
+     */
+    bool available(Backend backend);
+    
+    struct Transfer {
+        std::filesystem::path inpath;
+        std::filesystem::path outpath;
+    };
+    
+    enum class Status {
+        Converted,
+        Unreadable,
+        Failed,
+        Unwritable
+    };
+    
+    /**
+     Called on a worker thread with the whole of an input; returns false if
+     it cannot be converted.
+     */
+    using Transform = std::function<bool(size_t index, std::span<const std::byte> input, std::vector<std::byte>& output)>;
+    
+    // Called on the thread that called run() as each transfer finishes.
+    using Finished = std::function<void(size_t index, Status status)>;
+    
+    /**
+     Reads every input, converts it with transform on a pool of threads and
+     writes the result, all through a single io_uring. Up to depth files are
+     in flight at once, so converting those already read overlaps with
+     waiting on the rest. Outputs are written aside and renamed into place
+     as io::write does.
+     
+     Returns false, having done nothing, if io_uring is not available.
+     */
+    bool run(const std::vector<Transfer>& transfers, unsigned threads, const Transform& transform, const Finished& finished, unsigned depth = 64);
+}
+
+#endif /* aio_hpp */
@@ -0,0 +1,221 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "archive.hpp"
+#include "hpprgm.hpp"
+#include "cache.hpp"
+#include "detect.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace fs = std::filesystem;
+
+static constexpr char Magic[4] = {'H', 'P', 'A', 'R'};
+static constexpr uint16_t Version = 1;
+static constexpr size_t HeaderSize = 0x18;
+static constexpr size_t EntrySize = 32;
+static constexpr size_t Alignment = 4096;
+
+static uint64_t get(const std::byte* p, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) value |= static_cast<uint64_t>(p[i]) << (i * 8);
+    return value;
+}
+
+static std::byte* put(std::byte* p, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) *p++ = static_cast<std::byte>(value >> (i * 8));
+    return p;
+}
+
+static uint64_t align(uint64_t offset) {
+    return (offset + Alignment - 1) & ~uint64_t(Alignment - 1);
+}
+
+static archive::Format identify(std::span<const std::byte> data, const fs::path& path) {
+    detect::Format format = detect::sniff(data, path).format;
+    
+    // A container only counts if its code can actually be found.
+    if (detect::isContainer(format) && hpprgm::code(data).empty()) return archive::Other;
+    switch (format) {
+        case detect::Format::UTF16LE:
+        case detect::Format::UTF16BE:
+        case detect::Format::UTF8:
+            return archive::PRGM;
+        case detect::Format::G1: return archive::G1;
+        case detect::Format::G2: return archive::G2;
+        case detect::Format::Unknown: return archive::Other;
+    }
+    return archive::Other;
+}
+
+std::string_view archive::describe(Format format) {
+    switch (format) {
+        case PRGM: return "prgm";
+        case G1: return "G1";
+        case G2: return "G2";
+        case Other: return "other";
+    }
+    return "other";
+}
+
+// MARK: - Reading
+
+bool archive::Reader::open(const fs::path& path) {
+    members_.clear();
+    if (!file_.open(path, io::Access::Random)) return false;
+    
+    std::span<const std::byte> data = file_.bytes();
+    if (data.size() < HeaderSize || std::memcmp(data.data(), Magic, sizeof(Magic)) != 0) return false;
+    if (get(data.data() + 4, 2) != Version) return false;
+    
+    uint64_t count = get(data.data() + 8, 4);
+    uint64_t namesSize = get(data.data() + 12, 4);
+    if (count > (data.size() - HeaderSize) / EntrySize) return false;
+    
+    uint64_t names = HeaderSize + count * EntrySize;
+    if (namesSize > data.size() - names) return false;
+    
+    members_.reserve(count);
+    for (uint64_t i = 0; i < count; ++i) {
+        const std::byte* entry = data.data() + HeaderSize + i * EntrySize;
+        Member member;
+        
+        member.offset = get(entry, 8);
+        member.size = get(entry + 8, 8);
+        member.checksum = get(entry + 16, 8);
+        uint64_t nameOffset = get(entry + 24, 4);
+        uint64_t nameSize = get(entry + 28, 2);
+        member.format = static_cast<Format>(std::min<uint64_t>(get(entry + 30, 1), Other));
+        
+        if (nameOffset > namesSize || nameSize > namesSize - nameOffset) return false;
+        if (member.offset > data.size() || member.size > data.size() - member.offset) return false;
+        
+        member.name = std::string_view(reinterpret_cast<const char*>(data.data() + names + nameOffset), nameSize);
+        if (!members_.empty() && members_.back().name >= member.name) return false;
+        members_.push_back(member);
+    }
+    
+    return true;
+}
+
+const archive::Member* archive::Reader::find(std::string_view name) const {
+    auto it = std::lower_bound(members_.begin(), members_.end(), name, [](const Member& member, std::string_view name) {
+        return member.name < name;
+    });
+    if (it == members_.end() || it->name != name) return nullptr;
+    return &*it;
+}
+
+std::span<const std::byte> archive::Reader::bytes(const Member& member) const {
+    return file_.bytes().subspan(member.offset, member.size);
+}
+
+bool archive::Reader::verify(const Member& member) const {
+    return cache::hash(bytes(member)) == member.checksum;
+}
+
+// MARK: - Packing
+
+bool archive::pack(const fs::path& path, const std::vector<Input>& inputs, unsigned threads) {
+    struct Packed {
+        io::MappedFile file;
+        uint64_t checksum = 0;
+        Format format = Other;
+        bool read = false;
+    };
+    
+    std::vector<size_t> order(inputs.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return inputs[a].name < inputs[b].name; });
+    
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (inputs[order[i]].name.empty() || inputs[order[i]].name.size() > UINT16_MAX) return false;
+        if (i && inputs[order[i]].name == inputs[order[i - 1]].name) return false;
+    }
+    
+    std::vector<Packed> packed(inputs.size());
+    {
+        ThreadPool pool(threads);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            pool.submit([&, i] {
+                Packed& member = packed[i];
+                if (!member.file.open(inputs[i].path)) return;
+                member.checksum = cache::hash(member.file.bytes());
+                member.format = identify(member.file.bytes(), inputs[i].path);
+                member.read = true;
+            });
+        }
+        pool.wait();
+    }
+    
+    for (const auto& member : packed) {
+        if (!member.read) return false;
+    }
+    
+    size_t namesSize = 0;
+    for (const auto& input : inputs) namesSize += input.name.size();
+    if (namesSize > UINT32_MAX) return false;
+    
+    std::vector<std::byte> index(HeaderSize + inputs.size() * EntrySize + namesSize);
+    std::byte* at = index.data();
+    
+    std::memcpy(at, Magic, sizeof(Magic));
+    at = put(at + 4, Version, 2);
+    at = put(at, 0, 2);
+    at = put(at, inputs.size(), 4);
+    at = put(at, namesSize, 4);
+    at = put(at, 0, 8);
+    
+    static const std::byte zeros[Alignment]{};
+    std::vector<std::span<const std::byte>> segments{index};
+    uint64_t offset = index.size();
+    uint64_t nameOffset = 0;
+    std::byte* names = index.data() + HeaderSize + inputs.size() * EntrySize;
+    
+    for (size_t i : order) {
+        const Packed& member = packed[i];
+        const std::string& name = inputs[i].name;
+        uint64_t start = align(offset);
+        
+        at = put(at, start, 8);
+        at = put(at, member.file.size(), 8);
+        at = put(at, member.checksum, 8);
+        at = put(at, nameOffset, 4);
+        at = put(at, name.size(), 2);
+        at = put(at, member.format, 1);
+        at = put(at, 0, 1);
+        
+        std::memcpy(names + nameOffset, name.data(), name.size());
+        nameOffset += name.size();
+        
+        segments.push_back(std::span(zeros, start - offset));
+        segments.push_back(member.file.bytes());
+        offset = start + member.file.size();
+    }
+    
+    // Written aside and renamed into place, so readers never see half an archive.
+    return io::write(path, segments);
+}
@@ -0,0 +1,107 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef archive_hpp
+#define archive_hpp
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <filesystem>
+
+#include "io.hpp"
+
+namespace archive {
+    /*
+     An archive holds any number of programs, stored byte for byte as they
+     were packed. All fields are little-endian.
+     
+       0x00  "HPAR"
+       0x04  u16 version (1), u16 reserved
+       0x08  u32 number of members
+       0x0C  u32 size of the name table
+       0x10  u64 reserved
+       0x18  index, 32 bytes per member, sorted by name:
+               u64 offset, u64 size, u64 XXH64 checksum,
+               u32 name offset, u16 name length, u8 format, u8 reserved
+             name table, UTF-8 names one after another
+             members, each starting on a 4 KiB boundary
+     
+     Aligning members to pages means reading one program through a mapping
+     touches only that program's pages.
+     */
+    enum Format : uint8_t {
+        PRGM = 0,
+        G1 = 1,
+        G2 = 2,
+        Other = 3
+    };
+    
+    struct Member {
+        std::string_view name;
+        uint64_t offset = 0;
+        uint64_t size = 0;
+        uint64_t checksum = 0;
+        Format format = Other;
+    };
+    
+    std::string_view describe(Format format);
+    
+    /**
+     Read-only access to an archive through a mapping of the whole file.
+     */
+    class Reader {
+    public:
+        /**
+         Returns false if path is not an archive, or its index points
+         outside the file.
+         */
+        bool open(const std::filesystem::path& path);
+        
+        std::span<const Member> members() const { return members_; }
+        const Member* find(std::string_view name) const;
+        std::span<const std::byte> bytes(const Member& member) const;
+        bool verify(const Member& member) const;
+        
+    private:
+        io::MappedFile file_;
+        std::vector<Member> members_;
+    };
+    
+    struct Input {
+        std::string name;
+        std::filesystem::path path;
+    };
+    
+    /**
+     Writes the inputs to a new archive at path. Reading, checksumming and
+     identifying the inputs runs on a pool of threads. Fails if any input
+     cannot be read or two inputs share a name.
+     */
+    bool pack(const std::filesystem::path& path, const std::vector<Input>& inputs, unsigned threads);
+}
+
+#endif /* archive_hpp */
@@ -0,0 +1,348 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "batch.hpp"
+#include "hpprgm.hpp"
+#include "utf.hpp"
+#include "io.hpp"
+#include "stream.hpp"
+#include "cache.hpp"
+#include "threadpool.hpp"
+#include "font.hpp"
+#include "minify.hpp"
+#include "detect.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <iostream>
+
+#ifdef _WIN32
+#define STDOUT_FILENO 1
+#else
+#include <unistd.h>
+#endif
+
+static batch::Result finish(const batch::Job& job, bool success, const char* prefix, const std::filesystem::path& path, const char* suffix) {
+    std::ostringstream os;
+    batch::Result result;
+    
+    os << prefix << path.filename() << suffix;
+    result.inpath = job.inpath;
+    result.outpath = job.outpath;
+    result.success = success;
+    result.message = os.str();
+    return result;
+}
+
+static batch::Result notFound(const batch::Job& job) {
+    std::ostringstream os;
+    batch::Result result = finish(job, false, "❓File ", job.inpath, "");
+    
+    os << " not found at " << job.inpath.parent_path() << " location.";
+    result.message += os.str();
+    return result;
+}
+
+static batch::Result unableToExtract(const batch::Job& job) {
+    return finish(job, false, "❌ Unable extract PPL source code ", job.inpath, ".");
+}
+
+static batch::Result unrecognized(const batch::Job& job) {
+    return finish(job, false, "❌ Unrecognized format of file ", job.inpath, ".");
+}
+
+static batch::Result unableToConvert(const batch::Job& job, const std::exception& e) {
+    batch::Result result = finish(job, false, "❌ Unable to convert ", job.inpath, ": ");
+    
+    result.message += e.what();
+    result.message += ".";
+    return result;
+}
+
+static batch::Result unableToCreate(const batch::Job& job) {
+    return finish(job, false, "❌ Unable to create file ", job.outpath, ".");
+}
+
+static batch::Result created(const batch::Job& job) {
+    return finish(job, true, "✅ File ", job.outpath, " succefuly created.");
+}
+
+static batch::Result created(const batch::Job& job, size_t removed) {
+    batch::Result result = created(job);
+    
+    if (job.minify) result.message += " Minified, " + std::to_string(removed) + " bytes saved.";
+    return result;
+}
+
+// Only G1 headers carry values for exported variables.
+static bool compact(const batch::Job& job, std::u16string& str, hpprgm::Header& header) {
+    return job.compact && job.format == hpprgm::G1 && font::compact(str, header, job.exportLocal);
+}
+
+// Runs after compact(), which looks for font declarations at the start of a line.
+static size_t minified(const batch::Job& job, std::u16string& str) {
+    if (!job.minify) return 0;
+    
+    size_t size = str.size();
+    str = minify::code(str, job.shorten);
+    return (size - str.size()) * sizeof(char16_t);
+}
+
+// The input header is not carried over, only the code.
+static std::u16string load(std::span<const std::byte> data, detect::Format format) {
+    hpprgm::Header header;
+    std::u16string str = hpprgm::load(data, format, header).value_or(std::u16string());
+    
+    if (!detect::isContainer(format)) stats::code(str.size() * sizeof(char16_t));
+    return str;
+}
+
+/*
+ Streaming keeps memory flat however large the input, but only a plain
+ conversion can stream: minifying, and writing back the values a G1 header
+ holds, both need the whole program.
+ */
+static batch::Result convertToStdout(const batch::Job& job) {
+    bool staged = job.minify;
+    std::error_code ec;
+    
+    // Only a regular file can be looked at first without using up the input.
+    if (!staged && std::filesystem::is_regular_file(job.inpath, ec)) {
+        io::MappedFile file(job.inpath, io::Access::Random);
+        staged = hpprgm::holdsValues(file.bytes());
+    }
+    
+    if (!staged) {
+        if (!stream::convert(job.inpath, STDOUT_FILENO)) return unableToExtract(job);
+        return created(job);
+    }
+    
+    io::MappedFile file(job.inpath, job.copyInput ? io::Access::Copy : io::Access::Sequential);
+    if (!file.is_open()) return unableToExtract(job);
+    
+    detect::Format format = detect::sniff(file.bytes(), job.inpath).format;
+    if (format == detect::Format::Unknown) return unrecognized(job);
+    
+    std::u16string str = load(file.bytes(), format);
+    if (str.empty()) return unableToExtract(job);
+    
+    size_t removed = minified(job, str);
+    if (!stream::write(STDOUT_FILENO, str)) return unableToCreate(job);
+    return created(job, removed);
+}
+
+static batch::Result convertJob(const batch::Job& job) {
+    std::u16string str;
+    
+    if (!std::filesystem::exists(job.inpath)) return notFound(job);
+    
+    if (job.outpath == "/dev/stdout") return convertToStdout(job);
+    
+    io::MappedFile file(job.inpath, job.copyInput ? io::Access::Copy : io::Access::Sequential);
+    if (!file.is_open()) return unableToExtract(job);
+    
+    detect::Format format = detect::sniff(file.bytes(), job.inpath).format;
+    if (format == detect::Format::Unknown) return unrecognized(job);
+    
+    if (detect::isContainer(format) && job.outpath.extension() == ".prgm" && !job.minify && !hpprgm::holdsValues(file.bytes())) {
+        auto code = hpprgm::code(file.bytes());
+        
+        if (code.empty()) return unableToExtract(job);
+        if (!hpprgm::extract(code, job.outpath)) return unableToCreate(job);
+        return created(job);
+    }
+    
+    str = load(file.bytes(), format);
+    if (str.empty()) return unableToExtract(job);
+    
+    bool saved;
+    hpprgm::Header header;
+    bool compacted = job.outpath.extension() == ".hpprgm" && compact(job, str, header);
+    size_t removed = minified(job, str);
+    
+    if (compacted) {
+        saved = hpprgm::save(job.outpath, str, header);
+    } else if (job.outpath.extension() == ".hpprgm") {
+        saved = hpprgm::save(job.outpath, str, job.format);
+    } else {
+        saved = utf::save(job.outpath, str);
+    }
+    
+    if (!saved || !std::filesystem::exists(job.outpath)) return unableToCreate(job);
+    return created(job, removed);
+}
+
+/*
+ Anything other than the input bytes that changes the output: the container
+ format, and for G2 the program name that is taken from the file name.
+ */
+static std::string variant(const batch::Job& job) {
+    std::string variant;
+    
+    if (job.outpath.extension() == ".hpprgm") {
+        if (job.format == hpprgm::G1) variant = job.compact ? (job.exportLocal ? "G1:compact:local" : "G1:compact") : "G1";
+        else variant = "G2:" + job.outpath.stem().string();
+    }
+    if (job.minify) variant += job.shorten ? "+minify:shorten" : "+minify";
+    return variant;
+}
+
+static batch::Result convertCached(const batch::Job& job) {
+    if (job.cache.empty() || job.outpath == "/dev/stdout" || !std::filesystem::exists(job.inpath)) return convertJob(job);
+    
+    io::MappedFile file(job.inpath, job.copyInput ? io::Access::Copy : io::Access::Sequential);
+    if (!file.is_open()) return convertJob(job);
+    
+    std::filesystem::path entry = cache::entry(job.cache, file.bytes(), job.outpath, variant(job));
+    if (cache::fetch(entry, job.outpath)) return created(job);
+    
+    cache::detach(job.outpath);
+    batch::Result result = convertJob(job);
+    if (result.success) cache::store(entry, job.outpath);
+    return result;
+}
+
+/*
+ convertJob() for a file already in memory, as read by the io_uring
+ pipeline, producing the same bytes it would have written.
+ */
+static bool transcode(const batch::Job& job, std::span<const std::byte> input, std::vector<std::byte>& output, size_t& removed) {
+    detect::Format format = detect::sniff(input, job.inpath).format;
+    std::u16string str;
+    
+    if (format == detect::Format::Unknown) return false;
+    
+    if (detect::isContainer(format) && job.outpath.extension() == ".prgm" && !job.minify && !hpprgm::holdsValues(input)) {
+        auto code = hpprgm::code(input);
+        
+        if (code.empty()) return false;
+        hpprgm::extract(code, output);
+        return true;
+    }
+    
+    str = load(input, format);
+    if (str.empty()) return false;
+    
+    hpprgm::Header header;
+    bool compacted = job.outpath.extension() == ".hpprgm" && compact(job, str, header);
+    removed = minified(job, str);
+    
+    if (compacted) {
+        return hpprgm::save(output, str, header).has_value();
+    }
+    if (job.outpath.extension() == ".hpprgm") {
+        return hpprgm::save(output, str, job.format, utf::utf16(job.outpath.stem().string())).has_value();
+    }
+    
+    output.resize(2 + str.size() * 2);
+    output.resize(utf::encode(str, output.data(), utf::BOMle) - output.data());
+    return true;
+}
+
+static bool runPipelined(const std::vector<batch::Job>& jobs, unsigned threads, void (*report)(const batch::Result&), std::vector<batch::Result>& results) {
+    std::vector<aio::Transfer> transfers;
+    std::vector<size_t> removed(jobs.size());
+    
+    for (const auto& job : jobs) transfers.push_back({job.inpath, job.outpath});
+    
+    auto transform = [&](size_t index, std::span<const std::byte> input, std::vector<std::byte>& output) {
+        stats::reset();
+        stats::read(input.size());
+        bool success = transcode(jobs[index], input, output, removed[index]);
+        stats::wrote(output.size());
+        results[index].counters = stats::current();
+        return success;
+    };
+    
+    auto finished = [&](size_t index, aio::Status status) {
+        const batch::Job& job = jobs[index];
+        stats::Counters counters = results[index].counters;
+        
+        switch (status) {
+            case aio::Status::Converted:
+                results[index] = created(job, removed[index]);
+                break;
+            case aio::Status::Unreadable: {
+                // Runs on the ring's thread, outside any worker, so this must not throw.
+                std::error_code ec;
+                results[index] = std::filesystem::exists(job.inpath, ec) ? unableToExtract(job) : notFound(job);
+                break;
+            }
+            case aio::Status::Failed:
+                results[index] = unableToExtract(job);
+                break;
+            case aio::Status::Unwritable:
+                results[index] = unableToCreate(job);
+                break;
+        }
+        results[index].counters = counters;
+        if (report) report(results[index]);
+    };
+    
+    return aio::run(transfers, threads, transform, finished);
+}
+
+batch::Result batch::convert(const Job& job) {
+    Result result;
+    
+    /*
+     Filesystem queries throw on paths they cannot handle, and any step can
+     run out of memory; either way only this job fails, not the batch.
+     */
+    stats::reset();
+    try {
+        result = convertCached(job);
+    } catch (const std::exception& e) {
+        result = unableToConvert(job, e);
+    }
+    result.counters = stats::current();
+    return result;
+}
+
+std::vector<batch::Result> batch::run(const std::vector<Job>& jobs, unsigned threads, void (*report)(const Result&), aio::Backend backend) {
+    std::vector<Result> results(jobs.size());
+    std::mutex mutex;
+    
+    // The cache works on whole files by path, so cached jobs stay on the blocking path.
+    bool cached = std::any_of(jobs.begin(), jobs.end(), [](const Job& job) { return !job.cache.empty(); });
+    if (backend == aio::Backend::Uring && !cached && runPipelined(jobs, threads, report, results)) return results;
+    
+    {
+        ThreadPool pool(threads);
+        
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            pool.submit([&, i] {
+                results[i] = convert(jobs[i]);
+                if (!report) return;
+                
+                std::lock_guard<std::mutex> lock(mutex);
+                report(results[i]);
+            });
+        }
+        pool.wait();
+    }
+    
+    return results;
+}
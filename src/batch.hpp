@@ -0,0 +1,75 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef batch_hpp
+#define batch_hpp
+
+#include <string>
+#include <vector>
+#include <filesystem>
+
+#include "hpprgm.hpp"
+#include "stats.hpp"
+#include "aio.hpp"
+
+namespace batch {
+    struct Job {
+        std::filesystem::path inpath;
+        std::filesystem::path outpath;
+        hpprgm::Format format = hpprgm::G1;
+        std::filesystem::path cache;
+        
+        // Move font lists into the header of a G1 .hpprgm, with exportLocal LOCAL ones too, see font::compact().
+        bool compact = false;
+        bool exportLocal = false;
+        
+        // Strip comments and spaces from the code, and with shorten LOCAL names too, see minify::code().
+        bool minify = false;
+        bool shorten = false;
+        
+        // Read the input into memory rather than map it, for files an editor may rewrite mid-conversion.
+        bool copyInput = false;
+    };
+    
+    struct Result {
+        std::filesystem::path inpath;
+        std::filesystem::path outpath;
+        bool success = false;
+        std::string message;
+        stats::Counters counters;
+    };
+    
+    Result convert(const Job& job);
+    
+    /**
+     Converts the jobs on threads workers, calling report for each as it
+     finishes. With the Uring backend, reads and writes are queued on an
+     io_uring instead; jobs using a cache, or systems without io_uring, fall
+     back to Blocking.
+     */
+    std::vector<Result> run(const std::vector<Job>& jobs, unsigned threads, void (*report)(const Result&) = nullptr,
+                            aio::Backend backend = aio::Backend::Blocking);
+}
+
+#endif /* batch_hpp */
@@ -0,0 +1,173 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "cache.hpp"
+#include "../version_code.h"
+
+#include <atomic>
+#include <bit>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace fs = std::filesystem;
+
+// MARK: - XXH64
+
+static constexpr uint64_t Prime1 = 0x9E3779B185EBCA87ULL;
+static constexpr uint64_t Prime2 = 0xC2B2AE3D27D4EB4FULL;
+static constexpr uint64_t Prime3 = 0x165667B19E3779F9ULL;
+static constexpr uint64_t Prime4 = 0x85EBCA77C2B2AE63ULL;
+static constexpr uint64_t Prime5 = 0x27D4EB2F165667C5ULL;
+
+// XXH64 reads its input as little-endian words.
+static uint64_t read64(const std::byte* p) {
+    uint64_t value;
+    std::memcpy(&value, p, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) value = std::byteswap(value);
+    return value;
+}
+
+static uint32_t read32(const std::byte* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) value = std::byteswap(value);
+    return value;
+}
+
+static uint64_t round(uint64_t acc, uint64_t input) {
+    acc += input * Prime2;
+    acc = std::rotl(acc, 31);
+    return acc * Prime1;
+}
+
+static uint64_t merge(uint64_t acc, uint64_t value) {
+    acc ^= round(0, value);
+    return acc * Prime1 + Prime4;
+}
+
+uint64_t cache::hash(std::span<const std::byte> data, uint64_t seed) {
+    const std::byte* p = data.data();
+    const std::byte* end = p + data.size();
+    uint64_t h;
+    
+    if (data.size() >= 32) {
+        uint64_t v1 = seed + Prime1 + Prime2;
+        uint64_t v2 = seed + Prime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - Prime1;
+        
+        for (; p + 32 <= end; p += 32) {
+            v1 = round(v1, read64(p));
+            v2 = round(v2, read64(p + 8));
+            v3 = round(v3, read64(p + 16));
+            v4 = round(v4, read64(p + 24));
+        }
+        
+        h = std::rotl(v1, 1) + std::rotl(v2, 7) + std::rotl(v3, 12) + std::rotl(v4, 18);
+        h = merge(h, v1);
+        h = merge(h, v2);
+        h = merge(h, v3);
+        h = merge(h, v4);
+    } else {
+        h = seed + Prime5;
+    }
+    
+    h += data.size();
+    
+    for (; p + 8 <= end; p += 8) {
+        h ^= round(0, read64(p));
+        h = std::rotl(h, 27) * Prime1 + Prime4;
+    }
+    if (p + 4 <= end) {
+        h ^= read32(p) * Prime1;
+        h = std::rotl(h, 23) * Prime2 + Prime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= static_cast<uint64_t>(*p) * Prime5;
+        h = std::rotl(h, 11) * Prime1;
+    }
+    
+    h ^= h >> 33;
+    h *= Prime2;
+    h ^= h >> 29;
+    h *= Prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+// MARK: - Entries
+
+fs::path cache::entry(const fs::path& dir, std::span<const std::byte> input, const fs::path& outpath, std::string_view variant) {
+    std::string type = outpath.extension().string();
+    std::ostringstream os;
+    
+    uint64_t key = hash(input, NUMERIC_BUILD);
+    key = hash(std::as_bytes(std::span(type)), key);
+    key = hash(std::as_bytes(std::span(variant)), key);
+    
+    os << std::hex << std::setw(16) << std::setfill('0') << key << type;
+    return dir / os.str();
+}
+
+bool cache::fetch(const fs::path& entry, const fs::path& outpath) {
+    std::error_code ec;
+    
+    if (!fs::is_regular_file(entry, ec)) return false;
+    
+    fs::remove(outpath, ec);
+    fs::create_hard_link(entry, outpath, ec);
+    if (!ec) return true;
+    
+    // Different file systems, or links not supported.
+    ec.clear();
+    fs::copy_file(entry, outpath, fs::copy_options::overwrite_existing, ec);
+    return !ec;
+}
+
+bool cache::store(const fs::path& entry, const fs::path& outpath) {
+    static std::atomic<unsigned> count{0};
+    std::error_code ec;
+    std::ostringstream os;
+    
+    fs::create_directories(entry.parent_path(), ec);
+    
+    os << entry.filename().string() << ".tmp." << std::hash<std::thread::id>{}(std::this_thread::get_id()) << "." << count++;
+    fs::path temporary = entry.parent_path() / os.str();
+    
+    fs::copy_file(outpath, temporary, fs::copy_options::overwrite_existing, ec);
+    if (!ec) fs::rename(temporary, entry, ec);
+    if (!ec) return true;
+    
+    fs::remove(temporary, ec);
+    return false;
+}
+
+void cache::detach(const fs::path& outpath) {
+    std::error_code ec;
+    
+    if (fs::hard_link_count(outpath, ec) > 1 && !ec) fs::remove(outpath, ec);
+}
@@ -0,0 +1,68 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef cache_hpp
+#define cache_hpp
+
+#include <span>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <filesystem>
+
+namespace cache {
+    /**
+     64-bit XXH64 hash of data, fast enough to run over every input on every
+     build.
+     */
+    uint64_t hash(std::span<const std::byte> data, uint64_t seed = 0);
+    
+    /**
+     Path within dir of the cached output for input converted to a file like
+     outpath. The key covers the input bytes, the tool build, the output type
+     and anything else in variant that changes the output (such as the
+     container format, or the G2 program name).
+     */
+    std::filesystem::path entry(const std::filesystem::path& dir, std::span<const std::byte> input, const std::filesystem::path& outpath, std::string_view variant);
+    
+    /**
+     Puts the cached output in place at outpath, hard-linked where possible
+     and copied otherwise. Returns false on a cache miss.
+     */
+    bool fetch(const std::filesystem::path& entry, const std::filesystem::path& outpath);
+    
+    /**
+     Copies a freshly written outpath into the cache. The copy goes through a
+     temporary file and a rename, so other processes never see half an entry.
+     */
+    bool store(const std::filesystem::path& entry, const std::filesystem::path& outpath);
+    
+    /**
+     Unlinks outpath if it has other hard links, as fetched outputs do, so
+     writing a new output in place can never change what is cached.
+     */
+    void detach(const std::filesystem::path& outpath);
+}
+
+#endif /* cache_hpp */
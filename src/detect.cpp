@@ -0,0 +1,220 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-16
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "detect.hpp"
+#include "stats.hpp"
+
+#include <array>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+using detect::Format;
+
+namespace {
+    struct Probe {
+        std::span<const std::byte> prefix;
+        uint64_t size;
+        std::filesystem::path extension;
+    };
+    
+    struct Sniffer {
+        Format format;
+        int (*confidence)(const Probe& probe);
+        
+        // Extensions that usually hold this format and add to its confidence.
+        std::array<std::string_view, 2> extensions;
+    };
+    
+    constexpr int Certain = 100;
+    constexpr int Marked = 90;
+    constexpr int Likely = 60;
+    constexpr int Plausible = 50;
+    constexpr int Fallback = 40;
+    constexpr int ExtensionWeight = 10;
+}
+
+static uint32_t u32(std::span<const std::byte> data, size_t offset) {
+    return  static_cast<uint32_t>(data[offset])            | static_cast<uint32_t>(data[offset + 1]) << 8 |
+            static_cast<uint32_t>(data[offset + 2]) << 16  | static_cast<uint32_t>(data[offset + 3]) << 24;
+}
+
+static bool startsWith(std::span<const std::byte> data, std::initializer_list<uint8_t> bytes) {
+    if (data.size() < bytes.size()) return false;
+    size_t i = 0;
+    for (uint8_t byte : bytes) {
+        if (data[i++] != std::byte{byte}) return false;
+    }
+    return true;
+}
+
+// MARK: - Sniffers
+
+static int sniffG2(const Probe& probe) {
+    if (probe.prefix.size() < 4) return 0;
+    return u32(probe.prefix, 0) == 0xB28A617C ? Certain : 0;
+}
+
+static int sniffG1(const Probe& probe) {
+    if (probe.prefix.size() < 8) return 0;
+    
+    /*
+     A G1 container starts with a small little-endian header size, which
+     text cannot: four printable bytes, or a UTF-16 character and its high
+     byte, never add up to less than 1 MiB.
+     */
+    uint64_t header_size = u32(probe.prefix, 0);
+    if (header_size < 12 || header_size >= 0x100000) return 0;
+    if (probe.size != detect::UnknownSize && probe.size < header_size + 8) return 0;
+    
+    // With a short header the code size is in reach and the sizes must add up.
+    if (header_size + 8 <= probe.prefix.size()) {
+        uint64_t size = 4 + header_size + 4 + u32(probe.prefix, 4 + header_size);
+        if (probe.size == detect::UnknownSize) return Likely;
+        return probe.size == size || probe.size == size + 2 ? Certain : 0;
+    }
+    return Likely;
+}
+
+static int sniffUTF16(const Probe& probe, bool bigEndian) {
+    if (startsWith(probe.prefix, bigEndian ? std::initializer_list<uint8_t>{0xFE, 0xFF} : std::initializer_list<uint8_t>{0xFF, 0xFE})) return Marked;
+    
+    /*
+     Without a byte order mark, PPL is mostly ASCII, which leaves the high
+     byte of most code units zero and the low byte never so.
+     */
+    size_t units = probe.prefix.size() / 2, ascii = 0;
+    if (units < 2) return 0;
+    for (size_t i = 0; i < units; i++) {
+        std::byte high = probe.prefix[i * 2 + (bigEndian ? 0 : 1)];
+        std::byte low = probe.prefix[i * 2 + (bigEndian ? 1 : 0)];
+        if (low == std::byte{0} && high == std::byte{0}) return 0;
+        if (high == std::byte{0} && low != std::byte{0}) ascii++;
+    }
+    return ascii * 4 >= units * 3 ? Plausible : 0;
+}
+
+static int sniffUTF16LE(const Probe& probe) {
+    return sniffUTF16(probe, false);
+}
+
+static int sniffUTF16BE(const Probe& probe) {
+    return sniffUTF16(probe, true);
+}
+
+static int sniffUTF8(const Probe& probe) {
+    if (startsWith(probe.prefix, {0xEF, 0xBB, 0xBF})) return Marked;
+    if (probe.prefix.empty()) return 0;
+    
+    // Valid UTF-8 with no NUL, allowing for a sequence cut off by the probe.
+    bool truncated = probe.size == detect::UnknownSize || probe.prefix.size() < probe.size;
+    for (size_t i = 0; i < probe.prefix.size(); ) {
+        uint8_t lead = static_cast<uint8_t>(probe.prefix[i]);
+        if (lead == 0) return 0;
+        
+        size_t length = lead < 0x80 ? 1 : lead >= 0xC2 && lead < 0xE0 ? 2 : lead >= 0xE0 && lead < 0xF0 ? 3 : lead >= 0xF0 && lead < 0xF5 ? 4 : 0;
+        if (!length) return 0;
+        for (size_t j = 1; j < length; j++) {
+            if (i + j == probe.prefix.size()) return truncated ? Fallback : 0;
+            if ((static_cast<uint8_t>(probe.prefix[i + j]) & 0xC0) != 0x80) return 0;
+        }
+        i += length;
+    }
+    return Fallback;
+}
+
+/*
+ The registry. Adding a format is an entry here and a case in the decoders
+ that dispatch on it; on equal confidence the earlier entry wins.
+ */
+static constexpr Sniffer sniffers[] = {
+    {Format::G2, sniffG2, {".hpprgm", ".hpappprgm"}},
+    {Format::G1, sniffG1, {".hpprgm", ".hpappprgm"}},
+    {Format::UTF16LE, sniffUTF16LE, {".prgm"}},
+    {Format::UTF16BE, sniffUTF16BE, {".prgm"}},
+    {Format::UTF8, sniffUTF8, {".prgm"}}
+};
+
+// MARK: -
+
+detect::Match detect::sniff(std::span<const std::byte> prefix, uint64_t size, const std::filesystem::path& path) {
+    stats::Scope scope(stats::Detect);
+    Probe probe{prefix.first(std::min(prefix.size(), ProbeSize)), size, path.extension()};
+    Match match;
+    
+    for (const Sniffer& sniffer : sniffers) {
+        int confidence = sniffer.confidence(probe);
+        if (!confidence) continue;
+        
+        for (std::string_view extension : sniffer.extensions) {
+            if (!extension.empty() && probe.extension == extension) confidence = std::min(confidence + ExtensionWeight, Certain);
+        }
+        if (confidence > match.confidence) match = {sniffer.format, confidence};
+    }
+    
+    return match;
+}
+
+detect::Match detect::sniff(std::span<const std::byte> data, const std::filesystem::path& path) {
+    return sniff(data, data.size(), path);
+}
+
+detect::Match detect::sniff(const std::filesystem::path& path) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(path, ec);
+    if (ec) return Match();
+    
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    stats::syscall();
+    if (fd < 0) return Match();
+    
+    std::array<std::byte, ProbeSize> prefix;
+    ssize_t n;
+    do {
+        n = ::read(fd, prefix.data(), prefix.size());
+        stats::syscall();
+    } while (n < 0 && errno == EINTR);
+    ::close(fd);
+    stats::syscall();
+    
+    if (n < 0) return Match();
+    return sniff(std::span<const std::byte>(prefix.data(), static_cast<size_t>(n)), size, path);
+}
+
+
+bool detect::isContainer(Format format) {
+    return format == Format::G1 || format == Format::G2;
+}
+
+std::string_view detect::describe(Format format) {
+    switch (format) {
+        case Format::G1: return "G1 container";
+        case Format::G2: return "G2 container";
+        case Format::UTF16LE: return "UTF-16LE text";
+        case Format::UTF16BE: return "UTF-16BE text";
+        case Format::UTF8: return "UTF-8 text";
+        case Format::Unknown: break;
+    }
+    return "unknown format";
+}
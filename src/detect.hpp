@@ -0,0 +1,79 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-16
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef detect_hpp
+#define detect_hpp
+
+#include <span>
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <filesystem>
+
+namespace detect {
+    /*
+     Every sniffer works from the same first ProbeSize bytes of the input,
+     so working out what a file is costs one small read, or nothing extra
+     when the file is already mapped.
+     */
+    constexpr size_t ProbeSize = 64;
+    
+    // For inputs such as pipes whose length is not known up front.
+    constexpr uint64_t UnknownSize = UINT64_MAX;
+    
+    enum class Format {
+        Unknown,
+        G1,
+        G2,
+        UTF16LE,
+        UTF16BE,
+        UTF8
+    };
+    
+    struct Match {
+        Format format = Format::Unknown;
+        
+        // 0 to 100. Byte order marks and magic numbers score highest.
+        int confidence = 0;
+    };
+    
+    /**
+     Runs every registered sniffer over prefix, the start of an input of
+     size bytes, and returns the most confident match. The extension of
+     path, when given, only adds weight to the formats it usually holds, so
+     inputs without one, or with the wrong one, are still recognised.
+     */
+    Match sniff(std::span<const std::byte> prefix, uint64_t size, const std::filesystem::path& path = {});
+    
+    // sniff() for an input held in memory as a whole.
+    Match sniff(std::span<const std::byte> data, const std::filesystem::path& path = {});
+    
+    // sniff() reading the first ProbeSize bytes of the file at path.
+    Match sniff(const std::filesystem::path& path);
+    
+    bool isContainer(Format format);
+    std::string_view describe(Format format);
+}
+
+#endif /* detect_hpp */
@@ -0,0 +1,318 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "font.hpp"
+#include "cpu.hpp"
+
+#include <algorithm>
+
+#ifdef CPU_X86_64
+#include <immintrin.h>
+#endif
+
+using namespace font;
+
+static bool isSpace(char16_t ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r';
+}
+
+static bool isIdentifier(char16_t ch) {
+    return ch == '_' || (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+static size_t skipSpaces(std::u16string_view code, size_t i) {
+    while (i < code.size() && isSpace(code[i])) i++;
+    return i;
+}
+
+static size_t skipSpacesBack(std::u16string_view code, size_t i) {
+    while (i > 0 && isSpace(code[i - 1])) i--;
+    return i;
+}
+
+// MARK: - Hex Literals
+
+/*
+ Decodes the 16 hex digits at p, the first being the most significant.
+ Returns false if any of them is not a hex digit.
+ */
+
+#ifdef CPU_X86_64
+
+static __m128i inRange(__m128i v, char lo, char hi) {
+    __m128i clamped = _mm_min_epu8(_mm_max_epu8(v, _mm_set1_epi8(lo)), _mm_set1_epi8(hi));
+    return _mm_cmpeq_epi8(clamped, v);
+}
+
+static bool hex64(const char16_t* p, uint64_t& value) {
+    __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 8));
+    
+    // Units outside Latin-1 saturate to 00 or FF, neither of which is a digit.
+    __m128i ascii = _mm_packus_epi16(a, b);
+    __m128i lower = _mm_or_si128(ascii, _mm_set1_epi8(0x20));
+    __m128i digit = inRange(ascii, '0', '9');
+    __m128i letter = inRange(lower, 'a', 'f');
+    if (_mm_movemask_epi8(_mm_or_si128(digit, letter)) != 0xFFFF) return false;
+    
+    __m128i nibbles = _mm_or_si128(_mm_and_si128(digit, _mm_sub_epi8(ascii, _mm_set1_epi8('0'))),
+                                   _mm_and_si128(letter, _mm_sub_epi8(lower, _mm_set1_epi8('a' - 10))));
+    
+    // Each 16-bit lane holds a pair of digits, the first in its low byte.
+    __m128i bytes = _mm_or_si128(_mm_and_si128(_mm_slli_epi16(nibbles, 4), _mm_set1_epi16(0x00F0)), _mm_srli_epi16(nibbles, 8));
+    bytes = _mm_packus_epi16(bytes, bytes);
+    value = __builtin_bswap64(static_cast<uint64_t>(_mm_cvtsi128_si64(bytes)));
+    return true;
+}
+
+#else
+
+static bool hex64(const char16_t* p, uint64_t& value) {
+    value = 0;
+    for (int i = 0; i < 16; ++i) {
+        char16_t ch = p[i];
+        uint64_t nibble;
+        
+        if (ch >= '0' && ch <= '9') nibble = ch - '0';
+        else if (ch >= 'A' && ch <= 'F') nibble = ch - 'A' + 10;
+        else if (ch >= 'a' && ch <= 'f') nibble = ch - 'a' + 10;
+        else return false;
+        value = value << 4 | nibble;
+    }
+    return true;
+}
+
+#endif
+
+// A #XXXXXXXXXXXXXXXX:64h literal is 21 code units.
+static constexpr size_t LiteralSize = 21;
+
+static bool literal(std::u16string_view code, size_t at, uint64_t& value) {
+    if (at + LiteralSize > code.size() || code[at] != '#') return false;
+    if (code.substr(at + 17, 4) != u":64h") return false;
+    return hex64(code.data() + at + 1, value);
+}
+
+static bool number(std::u16string_view code, size_t& at, int64_t& value) {
+    bool negative = at < code.size() && code[at] == '-';
+    size_t i = at + (negative ? 1 : 0);
+    size_t start = i;
+    
+    value = 0;
+    while (i < code.size() && code[i] >= '0' && code[i] <= '9') value = value * 10 + (code[i++] - '0');
+    if (i == start || (i < code.size() && isIdentifier(code[i]))) return false;
+    
+    if (negative) value = -value;
+    at = i;
+    return true;
+}
+
+// MARK: - Parsing
+
+/*
+ Reads the literals of a word list up to and including its closing brace,
+ at being just past the opening one.
+ */
+static bool words(std::u16string_view code, size_t& at, std::vector<uint64_t>& words) {
+    uint64_t word;
+    
+    at = skipSpaces(code, at);
+    while (literal(code, at, word)) {
+        words.push_back(word);
+        at = skipSpaces(code, at + LiteralSize);
+        if (at >= code.size() || code[at] != ',') break;
+        at = skipSpaces(code, at + 1);
+    }
+    
+    if (at >= code.size() || code[at] != '}') return false;
+    at++;
+    return true;
+}
+
+/*
+ Reads ", first, last, yAdvance }" after the record list, leaving at just
+ past the closing brace.
+ */
+static bool metrics(std::u16string_view code, size_t& at, Font& font) {
+    int64_t values[3];
+    
+    for (int64_t& value : values) {
+        at = skipSpaces(code, at);
+        if (at >= code.size() || code[at] != ',') return false;
+        at = skipSpaces(code, at + 1);
+        if (!number(code, at, value)) return false;
+    }
+    
+    at = skipSpaces(code, at);
+    if (at >= code.size() || code[at] != '}') return false;
+    at++;
+    
+    if (values[0] < 0 || values[1] < values[0]) return false;
+    font.first = static_cast<uint32_t>(values[0]);
+    font.last = static_cast<uint32_t>(values[1]);
+    font.yAdvance = static_cast<int32_t>(values[2]);
+    return true;
+}
+
+/*
+ Looks back from the outer brace for "LOCAL NAME :=" or "EXPORT NAME :=" at
+ the start of a line, which is all compact() will replace.
+ */
+static void declaration(std::u16string_view code, size_t brace, Font& font) {
+    size_t i = skipSpacesBack(code, brace);
+    if (i < 2 || code.substr(i - 2, 2) != u":=") return;
+    
+    size_t end = skipSpacesBack(code, i - 2);
+    size_t start = end;
+    while (start > 0 && isIdentifier(code[start - 1])) start--;
+    if (start == end) return;
+    
+    size_t keywordEnd = skipSpacesBack(code, start);
+    if (keywordEnd == start) return;
+    size_t keyword = keywordEnd;
+    while (keyword > 0 && isIdentifier(code[keyword - 1])) keyword--;
+    
+    std::u16string_view word = code.substr(keyword, keywordEnd - keyword);
+    if (word != u"LOCAL" && word != u"EXPORT") return;
+    
+    size_t line = keyword;
+    while (line > 0 && (code[line - 1] == ' ' || code[line - 1] == '\t')) line--;
+    if (line > 0 && code[line - 1] != '\n' && code[line - 1] != '\r') return;
+    
+    font.name = code.substr(start, end - start);
+    font.exported = word == u"EXPORT";
+    font.begin = keyword;
+}
+
+static void index(Font& font) {
+    size_t count = size_t(font.last) - font.first + 1;
+    if (count != font.records.size()) return;
+    
+    size_t bitmapBytes = font.bitmap.size() * 8;
+    std::vector<Glyph> glyphs;
+    
+    glyphs.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t word = font.records[i];
+        Glyph glyph{
+            static_cast<uint32_t>(font.first + i),
+            static_cast<uint16_t>(word),
+            static_cast<uint8_t>(word >> 16),
+            static_cast<uint8_t>(word >> 24),
+            static_cast<uint8_t>(word >> 32),
+            static_cast<int8_t>(word >> 40),
+            static_cast<int8_t>(word >> 48)
+        };
+        
+        size_t bits = size_t(glyph.width) * glyph.height;
+        if (glyph.offset + (bits + 7) / 8 > bitmapBytes) return;
+        glyphs.push_back(glyph);
+    }
+    font.glyphs = std::move(glyphs);
+}
+
+std::vector<Font> font::parse(std::u16string_view code) {
+    std::vector<Font> fonts;
+    size_t i = 0;
+    
+    while ((i = code.find(u'#', i)) != std::u16string_view::npos) {
+        Font font;
+        uint64_t word;
+        
+        // The font opens with "{ {", the inner brace directly before the first bitmap literal.
+        size_t inner = skipSpacesBack(code, i);
+        size_t outer = inner > 0 ? skipSpacesBack(code, inner - 1) : 0;
+        if (inner == 0 || code[inner - 1] != '{' || outer == 0 || code[outer - 1] != '{' || !literal(code, i, word)) {
+            i++;
+            continue;
+        }
+        
+        size_t at = i;
+        bool parsed = words(code, at, font.bitmap);
+        if (parsed) {
+            at = skipSpaces(code, at);
+            parsed = at < code.size() && code[at] == ',';
+        }
+        if (parsed) {
+            at = skipSpaces(code, at + 1);
+            parsed = at < code.size() && code[at] == '{' && words(code, ++at, font.records) && metrics(code, at, font);
+        }
+        if (!parsed) {
+            i = std::max(at, i + 1);
+            continue;
+        }
+        
+        at = skipSpaces(code, at);
+        if (at < code.size() && code[at] == ';') at++;
+        font.end = at;
+        
+        declaration(code, outer - 1, font);
+        if (font.name.empty() || code[at - 1] != ';') font.name.clear();
+        index(font);
+        fonts.push_back(std::move(font));
+        i = at;
+    }
+    return fonts;
+}
+
+// MARK: - Packing
+
+bool font::compact(std::u16string& code, hpprgm::Header& header, bool locals) {
+    std::vector<Font> fonts = parse(code);
+    std::vector<const hpprgm::Value*> items;
+    std::u16string out;
+    size_t at = 0;
+    
+    std::erase_if(fonts, [locals](const Font& font) { return font.name.empty() || (!font.exported && !locals); });
+    if (fonts.empty()) return false;
+    
+    out.reserve(code.size());
+    for (const auto& font : fonts) {
+        out.append(code, at, font.begin - at);
+        out += u"EXPORT " + font.name + u";";
+        at = font.end;
+        
+        // Headers hold list members in the reverse of source order.
+        items.clear();
+        for (auto word = font.records.rbegin(); word != font.records.rend(); ++word) items.push_back(header.integer(*word));
+        const hpprgm::Value* records = header.list(items);
+        
+        items.clear();
+        for (auto word = font.bitmap.rbegin(); word != font.bitmap.rend(); ++word) items.push_back(header.integer(*word));
+        const hpprgm::Value* bitmap = header.list(items);
+        
+        const hpprgm::Value* members[] = {
+            header.real(font.yAdvance),
+            header.real(font.last),
+            header.real(font.first),
+            records,
+            bitmap
+        };
+        header.addVariable(font.name, header.list(members));
+    }
+    out.append(code, at);
+    
+    code = std::move(out);
+    return true;
+}
@@ -0,0 +1,105 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef font_hpp
+#define font_hpp
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+
+#include "header.hpp"
+
+namespace font {
+    /*
+     Font programs hold an Adafruit GFX style font as a PPL list:
+     
+       LOCAL NAME := {
+        { #XXXXXXXXXXXXXXXX:64h, ... },
+        { #XXXXXXXXXXXXXXXX:64h, ... }, first, last, yAdvance
+       };
+     
+     The first list holds the packed glyph bitmaps, the second one 64-bit
+     record per glyph from first to last:
+     
+       bits  0-15  offset of the glyph's bitmap, in bytes
+       bits 16-23  width
+       bits 24-31  height
+       bits 32-39  xAdvance
+       bits 40-47  dX, signed
+       bits 48-55  dY, signed
+     */
+    
+    struct Glyph {
+        uint32_t code;
+        uint16_t offset;
+        uint8_t width;
+        uint8_t height;
+        uint8_t advance;
+        int8_t dx;
+        int8_t dy;
+    };
+    
+    struct Font {
+        std::u16string name;
+        
+        // Declared with EXPORT rather than LOCAL.
+        bool exported = false;
+        
+        // The declaration in the source, in code units, including its ';'.
+        size_t begin = 0;
+        size_t end = 0;
+        
+        // Both word lists, in source order.
+        std::vector<uint64_t> bitmap;
+        std::vector<uint64_t> records;
+        uint32_t first = 0;
+        uint32_t last = 0;
+        int32_t yAdvance = 0;
+        
+        // Empty if there is not a record for every glyph, or one points past the bitmap.
+        std::vector<Glyph> glyphs;
+    };
+    
+    /**
+     Every font literal in code. Each #XXXXXXXXXXXXXXXX:64h literal is
+     decoded 16 digits at a time.
+     */
+    std::vector<Font> parse(std::u16string_view code);
+    
+    /**
+     Moves every exported font in code, and with locals every LOCAL one too,
+     into header as an exported variable holding the same list in binary,
+     leaving an EXPORT declaration in its place. Each word then takes 20
+     bytes in the container instead of the 46 of its text. Returns false,
+     changing nothing, if code has no such fonts.
+     
+     A LOCAL font moved into the header becomes a global that other programs
+     exporting the same name collide with, hence it being opt-in.
+     */
+    bool compact(std::u16string& code, hpprgm::Header& header, bool locals = false);
+}
+
+#endif /* font_hpp */
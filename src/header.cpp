@@ -0,0 +1,454 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "header.hpp"
+
+#include <new>
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+
+static uint16_t u16(std::span<const std::byte> data, size_t offset) {
+    return static_cast<uint16_t>(static_cast<uint16_t>(data[offset]) |
+                                 static_cast<uint16_t>(data[offset + 1]) << 8);
+}
+
+static uint32_t u32(std::span<const std::byte> data, size_t offset) {
+    return static_cast<uint32_t>(u16(data, offset)) | static_cast<uint32_t>(u16(data, offset + 2)) << 16;
+}
+
+static uint64_t u64(std::span<const std::byte> data, size_t offset) {
+    return static_cast<uint64_t>(u32(data, offset)) | static_cast<uint64_t>(u32(data, offset + 4)) << 32;
+}
+
+static std::byte* put(std::byte* out, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) {
+        *out++ = static_cast<std::byte>(value >> (i * 8));
+    }
+    return out;
+}
+
+// MARK: - Value
+
+double hpprgm::Value::real() const {
+    if (list || type != Real) return 0.0;
+    
+    // Top byte: sign nibble (9 for negative) and the leading digit.
+    double digits = static_cast<double>((mantissa >> 56) & 0x0F);
+    for (int shift = 52; shift >= 0; shift -= 4) {
+        digits = digits * 10.0 + static_cast<double>((mantissa >> shift) & 0x0F);
+    }
+    
+    double number = digits * std::pow(10.0, exponent - 14);
+    return ((mantissa >> 60) == 0x09) ? -number : number;
+}
+
+static void appendSource(const hpprgm::Value& value, std::u16string& out) {
+    if (value.list) {
+        out += u'{';
+        for (size_t i = value.items.size(); i-- > 0; ) {
+            appendSource(value.items[i], out);
+            if (i) out += u',';
+        }
+        out += u'}';
+        return;
+    }
+    
+    switch (value.type) {
+        case hpprgm::Value::Integer: {
+            static const char16_t digits[] = u"0123456789ABCDEF";
+            out += u'#';
+            for (int shift = 60; shift >= 0; shift -= 4) out += digits[(value.mantissa >> shift) & 0x0F];
+            out += u":64h";
+            return;
+        }
+            
+        case hpprgm::Value::String:
+            out += u'"';
+            for (char16_t ch : value.string) {
+                if (ch == u'"' || ch == u'\\') out += u'\\';
+                out += ch;
+            }
+            out += u'"';
+            return;
+            
+        default:
+            break;
+    }
+    
+    // Fifteen BCD digits, d.dddddddddddddd times ten to the exponent.
+    std::u16string digits;
+    for (int shift = 56; shift >= 0; shift -= 4) digits += static_cast<char16_t>(u'0' + ((value.mantissa >> shift) & 0x0F));
+    while (digits.size() > 1 && digits.back() == u'0') digits.pop_back();
+    
+    if ((value.mantissa >> 60) == 0x09) out += u'-';
+    if (digits == u"0") {
+        out += u'0';
+    } else if (value.exponent >= 0 && value.exponent < 15) {
+        size_t point = static_cast<size_t>(value.exponent) + 1;
+        if (digits.size() < point) digits.append(point - digits.size(), u'0');
+        out += digits.substr(0, point);
+        if (digits.size() > point) out += u"." + digits.substr(point);
+    } else if (value.exponent < 0 && value.exponent > -5) {
+        out += u"0." + std::u16string(static_cast<size_t>(-value.exponent - 1), u'0') + digits;
+    } else {
+        out += digits.substr(0, 1);
+        if (digits.size() > 1) out += u"." + digits.substr(1);
+        for (char ch : "E" + std::to_string(value.exponent)) out += static_cast<char16_t>(ch);
+    }
+}
+
+std::u16string hpprgm::Value::source() const {
+    std::u16string out;
+    
+    appendSource(*this, out);
+    return out;
+}
+
+// MARK: - Header
+
+hpprgm::Header::Header() : storage_(std::make_unique<Storage>()) {
+}
+
+void hpprgm::Header::clear() {
+    storage_ = std::make_unique<Storage>();
+    unknown = 0;
+    reserved.fill(std::byte{0});
+}
+
+template <typename T>
+T* hpprgm::Header::allocate(size_t count) {
+    return static_cast<T*>(storage_->arena.allocate(sizeof(T) * std::max<size_t>(count, 1), alignof(T)));
+}
+
+std::u16string_view hpprgm::Header::copy(std::u16string_view str) {
+    if (str.empty()) return std::u16string_view();
+    
+    auto units = allocate<char16_t>(str.size());
+    std::memcpy(units, str.data(), str.size() * sizeof(char16_t));
+    return std::u16string_view(units, str.size());
+}
+
+uint16_t hpprgm::Header::variables() const {
+    uint16_t count = 0;
+    for (const auto& entry : storage_->entries) count += entry.type == Entry::Variable;
+    return count;
+}
+
+uint16_t hpprgm::Header::functions() const {
+    uint16_t count = 0;
+    for (const auto& entry : storage_->entries) count += entry.type == Entry::Function;
+    return count;
+}
+
+void hpprgm::Header::addFunction(std::u16string_view name) {
+    storage_->entries.push_back({Entry::Function, copy(name), nullptr});
+}
+
+void hpprgm::Header::addVariable(std::u16string_view name, const Value* value) {
+    storage_->entries.push_back({Entry::Variable, copy(name), value});
+}
+
+const hpprgm::Value* hpprgm::Header::real(int32_t exponent, uint64_t mantissa) {
+    auto value = new (allocate<Value>()) Value;
+    value->type = Value::Real;
+    value->exponent = exponent;
+    value->mantissa = mantissa;
+    return value;
+}
+
+const hpprgm::Value* hpprgm::Header::real(double number) {
+    if (number == 0.0 || !std::isfinite(number)) return real(0, 0);
+    
+    double magnitude = std::fabs(number);
+    int32_t exponent = static_cast<int32_t>(std::floor(std::log10(magnitude)));
+    auto digits = static_cast<uint64_t>(std::llround(magnitude / std::pow(10.0, exponent - 14)));
+    
+    // Rounding can carry into a sixteenth digit.
+    if (digits >= 1000000000000000ULL) {
+        digits /= 10;
+        exponent++;
+    }
+    
+    uint64_t mantissa = 0;
+    for (int shift = 0; shift <= 56; shift += 4) {
+        mantissa |= (digits % 10) << shift;
+        digits /= 10;
+    }
+    if (number < 0) mantissa |= 0x9ULL << 60;
+    
+    return real(exponent, mantissa);
+}
+
+const hpprgm::Value* hpprgm::Header::integer(uint64_t number) {
+    auto value = new (allocate<Value>()) Value;
+    value->type = Value::Integer;
+    value->exponent = 2;
+    value->mantissa = number;
+    return value;
+}
+
+const hpprgm::Value* hpprgm::Header::string(std::u16string_view str) {
+    auto value = new (allocate<Value>()) Value;
+    value->type = Value::String;
+    value->string = copy(str);
+    return value;
+}
+
+const hpprgm::Value* hpprgm::Header::list(std::span<const Value* const> items, uint16_t flags) {
+    auto members = allocate<Value>(items.size());
+    auto slots = allocate<uint32_t>(items.size());
+    
+    for (size_t i = 0; i < items.size(); ++i) {
+        new (&members[i]) Value(*items[i]);
+        slots[i] = 0;
+    }
+    
+    auto value = new (allocate<Value>()) Value;
+    value->list = true;
+    value->type = flags;
+    value->items = std::span<const Value>(members, items.size());
+    value->slots = std::span<const uint32_t>(slots, items.size());
+    return value;
+}
+
+// MARK: - Parsing
+
+/*
+ Lists nest by recursion, so a crafted header could otherwise run the
+ stack out; real programs come nowhere near this.
+ */
+static constexpr unsigned MaximumDepth = 64;
+
+bool hpprgm::Header::parseValue(std::span<const std::byte> data, size_t& offset, Value& value, unsigned depth) {
+    if (offset + 4 > data.size() || depth > MaximumDepth) return false;
+    
+    uint16_t kind = u16(data, offset);
+    value.type = u16(data, offset + 2);
+    offset += 4;
+    
+    if (kind == 0x0001) {
+        if (offset + 4 > data.size()) return false;
+        
+        uint16_t count = u16(data, offset);
+        value.list = true;
+        value.reserved = u16(data, offset + 2);
+        offset += 4;
+        
+        if (offset + count * 4 > data.size()) return false;
+        auto slots = allocate<uint32_t>(count);
+        for (uint16_t i = 0; i < count; ++i, offset += 4) {
+            slots[i] = u32(data, offset);
+        }
+        
+        // One allocation for all the members of this list.
+        auto members = allocate<Value>(count);
+        for (uint16_t i = 0; i < count; ++i) {
+            new (&members[i]) Value;
+            if (!parseValue(data, offset, members[i], depth + 1)) return false;
+        }
+        
+        value.slots = std::span<const uint32_t>(slots, count);
+        value.items = std::span<const Value>(members, count);
+        return true;
+    }
+    
+    if (kind != 0x0002) return false;
+    
+    switch (value.type) {
+        case Value::Real:
+        case Value::Integer:
+            if (offset + 12 > data.size()) return false;
+            value.exponent = static_cast<int32_t>(u32(data, offset));
+            value.mantissa = u64(data, offset + 4);
+            offset += 12;
+            return true;
+            
+        case Value::String: {
+            if (offset + 2 > data.size()) return false;
+            size_t length = u16(data, offset);
+            offset += 2;
+            
+            if (offset + length * 2 + 2 > data.size()) return false;
+            auto units = allocate<char16_t>(length);
+            for (size_t i = 0; i < length; ++i) {
+                units[i] = static_cast<char16_t>(u16(data, offset + i * 2));
+            }
+            value.string = std::u16string_view(units, length);
+            offset += length * 2 + 2;
+            return true;
+        }
+            
+        default:
+            return false;
+    }
+}
+
+bool hpprgm::Header::parse(std::span<const std::byte> data) {
+    clear();
+    
+    if (data.size() < 16) return false;
+    
+    size_t end = 4 + static_cast<size_t>(u32(data, 0));
+    if (end < 16 || end > data.size()) return false;
+    data = data.first(end);
+    
+    /*
+     No node takes more than four times the bytes it was read from, so a
+     single block from the upstream allocator normally holds the whole file.
+     */
+    storage_ = std::make_unique<Storage>(end * 4 + 256);
+    
+    size_t variables = u16(data, 4);
+    size_t functions = u16(data, 8);
+    unknown = u16(data, 6);
+    std::memcpy(reserved.data(), data.data() + 10, reserved.size());
+    
+    size_t offset = 16;
+    storage_->entries.reserve(variables + functions);
+    for (size_t i = 0; i < variables + functions; ++i) {
+        if (offset + 2 > end) break;
+        
+        Entry entry;
+        entry.type = static_cast<Entry::Type>(u16(data, offset));
+        offset += 2;
+        
+        // The name runs until 00 00 00 00.
+        size_t length = 0;
+        while (offset + length * 2 + 2 <= end && u16(data, offset + length * 2) != 0) length++;
+        
+        if (offset + length * 2 + 4 > end || (entry.type != Entry::Variable && entry.type != Entry::Function)) {
+            clear();
+            return false;
+        }
+        
+        auto units = allocate<char16_t>(length);
+        for (size_t n = 0; n < length; ++n) {
+            units[n] = static_cast<char16_t>(u16(data, offset + n * 2));
+        }
+        entry.name = std::u16string_view(units, length);
+        offset += length * 2 + 4;
+        storage_->entries.push_back(entry);
+    }
+    
+    // Value blocks follow in the same order as the variables they belong to.
+    for (auto& entry : storage_->entries) {
+        if (entry.type != Entry::Variable) continue;
+        
+        if (offset + 4 > end) break;
+        size_t size = u32(data, offset);
+        offset += 4;
+        
+        size_t next = offset + size;
+        auto value = new (allocate<Value>()) Value;
+        if (next > end || !parseValue(data.first(next), offset, *value) || offset != next) {
+            clear();
+            return false;
+        }
+        entry.value = value;
+    }
+    
+    if (storage_->entries.size() != variables + functions) {
+        clear();
+        return false;
+    }
+    
+    return true;
+}
+
+// MARK: - Writing
+
+size_t hpprgm::Header::valueSize(const Value& value) {
+    if (value.list) {
+        size_t size = 4 + 4 + value.items.size() * 4;
+        for (const auto& item : value.items) size += valueSize(item);
+        return size;
+    }
+    
+    if (value.type == Value::String) return 4 + 2 + value.string.size() * 2 + 2;
+    return 4 + 12;
+}
+
+std::byte* hpprgm::Header::writeValue(std::byte* out, const Value& value) {
+    out = put(out, value.list ? 0x0001 : 0x0002, 2);
+    out = put(out, value.type, 2);
+    
+    if (value.list) {
+        out = put(out, value.items.size(), 2);
+        out = put(out, value.reserved, 2);
+        for (size_t i = 0; i < value.items.size(); ++i) {
+            out = put(out, i < value.slots.size() ? value.slots[i] : 0, 4);
+        }
+        for (const auto& item : value.items) out = writeValue(out, item);
+        return out;
+    }
+    
+    if (value.type == Value::String) {
+        out = put(out, value.string.size(), 2);
+        for (char16_t ch : value.string) out = put(out, ch, 2);
+        return put(out, 0, 2);
+    }
+    
+    out = put(out, static_cast<uint32_t>(value.exponent), 4);
+    return put(out, value.mantissa, 8);
+}
+
+size_t hpprgm::Header::size() const {
+    size_t size = 16;
+    
+    for (const auto& entry : storage_->entries) {
+        size += 2 + entry.name.size() * 2 + 4;
+        if (entry.type == Entry::Variable && entry.value) size += 4 + valueSize(*entry.value);
+    }
+    return size;
+}
+
+std::byte* hpprgm::Header::write(std::byte* out) const {
+    out = put(out, size() - 4, 4);
+    out = put(out, variables(), 2);
+    out = put(out, unknown, 2);
+    out = put(out, functions(), 2);
+    out = std::copy(reserved.begin(), reserved.end(), out);
+    
+    for (const auto& entry : storage_->entries) {
+        out = put(out, entry.type, 2);
+        for (char16_t ch : entry.name) out = put(out, ch, 2);
+        out = put(out, 0, 4);
+    }
+    
+    for (const auto& entry : storage_->entries) {
+        if (entry.type != Entry::Variable || !entry.value) continue;
+        out = put(out, valueSize(*entry.value), 4);
+        out = writeValue(out, *entry.value);
+    }
+    
+    return out;
+}
+
+std::vector<std::byte> hpprgm::Header::bytes() const {
+    std::vector<std::byte> out(size());
+    
+    write(out.data());
+    return out;
+}
@@ -0,0 +1,157 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef header_hpp
+#define header_hpp
+
+#include <span>
+#include <array>
+#include <memory>
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <string_view>
+#include <memory_resource>
+
+namespace hpprgm {
+    /**
+     A value stored for an exported variable in a G1 header (see
+     hpprgm_format.md). Nodes, strings and lists all live in the arena of the
+     Header they belong to, so a Value is only valid for as long as its
+     Header is.
+     */
+    struct Value {
+        enum Type : uint16_t {
+            Real = 0x0110,
+            Integer = 0x2011,
+            String = 0x0212
+        };
+        
+        bool list = false;
+        
+        // Single value: one of Type. List: the flags word (0x0016, 0x0116, ...).
+        uint16_t type = Real;
+        
+        // Real: signed power of ten. Integer: the base marker, 2 in all known files.
+        int32_t exponent = 0;
+        
+        // Real: 15 BCD digits, the most significant in the top byte. Integer: the value.
+        uint64_t mantissa = 0;
+        
+        std::u16string_view string;
+        
+        // List members in file order, which is the reverse of the source.
+        std::span<const Value> items;
+        std::span<const uint32_t> slots;
+        uint16_t reserved = 0;
+        
+        double real() const;
+        
+        /**
+         The value as PPL source, as written after "EXPORT NAME :=": integers
+         as 64-bit hex literals and list members back in source order.
+         */
+        std::u16string source() const;
+    };
+    
+    struct Entry {
+        enum Type : uint16_t {
+            Variable = 0x30,
+            Function = 0x31
+        };
+        
+        Type type = Variable;
+        std::u16string_view name;
+        const Value* value = nullptr;
+    };
+    
+    /**
+     In-memory model of the G1 header: the entry table of exported variables
+     and functions, followed by one value block per variable.
+     */
+    class Header {
+    public:
+        Header();
+        
+        /**
+         Parses the header of a G1 container. Returns false, leaving the
+         header empty, if the data is not a G1 container or the header does
+         not follow the documented layout.
+         */
+        bool parse(std::span<const std::byte> data);
+        
+        /**
+         The serialized header, starting with its 4-byte size.
+         */
+        std::vector<std::byte> bytes() const;
+        size_t size() const;
+        
+        /**
+         Writes the serialized header to out, which must have room for size()
+         bytes, and returns the end of what was written.
+         */
+        std::byte* write(std::byte* out) const;
+        
+        std::span<const Entry> entries() const { return storage_->entries; }
+        uint16_t variables() const;
+        uint16_t functions() const;
+        
+        void clear();
+        void addFunction(std::u16string_view name);
+        void addVariable(std::u16string_view name, const Value* value);
+        
+        // Values built here are owned by this header's arena.
+        const Value* real(double number);
+        const Value* real(int32_t exponent, uint64_t mantissa);
+        const Value* integer(uint64_t value);
+        const Value* string(std::u16string_view str);
+        const Value* list(std::span<const Value* const> items, uint16_t flags = 0x0016);
+        
+        uint16_t unknown = 0;
+        std::array<std::byte, 6> reserved{};
+        
+    private:
+        std::u16string_view copy(std::u16string_view str);
+        bool parseValue(std::span<const std::byte> data, size_t& offset, Value& value, unsigned depth = 0);
+        static size_t valueSize(const Value& value);
+        static std::byte* writeValue(std::byte* out, const Value& value);
+        
+        /**
+         Everything the header points into. Replacing it as a whole frees the
+         previous file's nodes in one go and lets the arena be sized up front.
+         */
+        struct Storage {
+            explicit Storage(size_t capacity = 256) : arena(capacity), entries(&arena) {}
+            std::pmr::monotonic_buffer_resource arena;
+            std::pmr::vector<Entry> entries;
+        };
+        
+        template <typename T>
+        T* allocate(size_t count = 1);
+        
+        std::unique_ptr<Storage> storage_;
+    };
+}
+
+#endif /* header_hpp */
@@ -24,138 +24,535 @@
 
 #include "hpprgm.hpp"
 #include "utf.hpp"
+#include "io.hpp"
+#include "stats.hpp"
+#include "search.hpp"
+#include "detect.hpp"
 
+#include <cstring>
+#include <algorithm>
+#include <bit>
 #include <iostream>
 
-static bool isG1(const std::filesystem::path& path) {
-    std::ifstream is;
-    uint32_t header_size, code_size;
+// Container fields are little-endian whatever the host.
+static uint32_t u32(std::span<const std::byte> data, size_t offset) {
+    uint32_t value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) value = std::byteswap(value);
+    return value;
+}
+
+static uint16_t u16(std::span<const std::byte> data, size_t offset) {
+    uint16_t value;
+    std::memcpy(&value, data.data() + offset, sizeof(value));
+    if constexpr (std::endian::native == std::endian::big) value = std::byteswap(value);
+    return value;
+}
+
+static bool isG1(std::span<const std::byte> data) {
+    if (data.size() < 4) return false;
     
-    if (!std::filesystem::exists(path)) return false;
-    auto filesize = std::filesystem::file_size(path);
+    uint64_t header_size = u32(data, 0);
+    if (data.size() < header_size + 8) return false;
     
-    is.open(path, std::ios::in | std::ios::binary);
-    is.read(reinterpret_cast<char*>(&header_size), sizeof(header_size));
-    if (filesize < header_size + 4) {
-        is.close();
-        return false;
-    }
-    is.seekg(header_size, std::ios::cur);
-    is.read(reinterpret_cast<char*>(&code_size), sizeof(code_size));
-    is.close();
+    uint64_t code_size = u32(data, 4 + header_size);
+    uint64_t size = 4 + header_size + 4 + code_size;
+    return data.size() == size || data.size() - size == 2;
+}
+
+static bool isG2(std::span<const std::byte> data) {
+    if (data.size() < 4) return false;
+    return u32(data, 0) == 0xB28A617C;
+}
+
+static bool hasCarriageReturn(std::span<const std::byte> code) {
+    const void* first = code.data();
+    const void* last = code.data() + code.size();
     
-    uint32_t size = 4 + header_size + 4 + code_size;
-    return filesize == size || filesize - size == 2;
+    while (const void* found = std::memchr(first, '\r', static_cast<const std::byte*>(last) - static_cast<const std::byte*>(first))) {
+        size_t offset = static_cast<const std::byte*>(found) - code.data();
+        if (offset % 2 == 0 && offset + 1 < code.size() && code[offset + 1] == std::byte{0}) return true;
+        first = static_cast<const std::byte*>(found) + 1;
+    }
+    return false;
+}
+
+static std::u16string extractPPLCode(std::span<const std::byte> data) {
+    std::span<const std::byte> code = hpprgm::code(data);
+    stats::Scope scope(stats::Extract);
+    return utf::decode(code);
+}
+
+/*
+ Writes the values a G1 header holds for exported variables back into the
+ code wherever it declares them bare, as compaction leaves them, so that
+ extracting the code does not lose program data kept in the header.
+ */
+static void restore(std::u16string& str, const hpprgm::Header& header) {
+    for (const auto& entry : header.entries()) {
+        if (entry.type != hpprgm::Entry::Variable || !entry.value) continue;
+        
+        std::u16string name = u"EXPORT " + std::u16string(entry.name);
+        std::u16string bare = name + u";";
+        for (size_t at = str.find(bare); at != std::u16string::npos; at = str.find(bare, at + 1)) {
+            size_t line = at;
+            while (line > 0 && (str[line - 1] == ' ' || str[line - 1] == '\t')) line--;
+            if (line > 0 && str[line - 1] != '\n' && str[line - 1] != '\r') continue;
+            
+            str.replace(at, bare.size(), name + u" := " + entry.value->source() + u";");
+            break;
+        }
+    }
 }
 
-static bool isG2(const std::filesystem::path& path) {
-    std::ifstream is;
-    uint32_t sig;
+
+std::span<const std::byte> hpprgm::code(std::span<const std::byte> data) {
+    size_t offset = data.size();
+    stats::Scope detect(stats::Detect);
     
-    is.open(path, std::ios::in | std::ios::binary);
-    is.read(reinterpret_cast<char*>(&sig), sizeof(sig));
-    is.close();
+    if (isG1(data)) {
+        // The code follows the header and its own 4-byte size.
+        offset = 4 + u32(data, 0) + 4;
+    } else if (isG2(data)) {
+        // The code record follows the first 9B 00 C0 00 on a unit boundary.
+        for (size_t i = search::find(data, 0x009B); i != search::npos; i = search::find(data, 0x009B, i + 1)) {
+            if (i * 2 + 4 > data.size() || u16(data, i * 2 + 2) != 0x00C0) continue;
+            offset = i * 2 + 4;
+            break;
+        }
+    }
     
-    return sig == 0xB28A617C;
+    stats::Scope extract(stats::Extract);
+    std::span<const std::byte> code = data.subspan(offset);
+    size_t size = search::find(code, 0);
+    size = size == search::npos ? code.size() & ~size_t(1) : size * 2;
+    stats::code(size);
+    return code.first(size);
 }
 
-static std::wstring extractPPLCode(const std::filesystem::path& path) {
-    std::streampos pos, codePos;
-    std::wstring wstr;
-    std::ifstream is;
+
+bool hpprgm::extract(std::span<const std::byte> code, const std::filesystem::path& path) {
+    static const std::byte bom[] = {std::byte{0xFF}, std::byte{0xFE}};
     
-    is.open(path, std::ios::in | std::ios::binary);
-    if (!is.is_open()) return wstr;
+    /*
+     The container already holds UTF-16LE, so unless there are carriage
+     returns to drop the .prgm is just a byte order mark and the code as is.
+     */
+    if (!hasCarriageReturn(code)) return io::write(path, {bom, code});
     
-    if (isG1(path)) {
-        uint32_t header_size, code_size;
-        auto filesize = std::filesystem::file_size(path);
-        is.read(reinterpret_cast<char*>(&header_size), sizeof(header_size));
-        if (filesize < header_size + 4) {
-            is.close();
-            return wstr;
-        }
-        is.seekg(header_size - 2, std::ios::cur);
-        is.read(reinterpret_cast<char*>(&code_size), sizeof(code_size));
-        wstr = utf::read(is, utf::BOMnone);
-        is.close();
-        
-        return wstr;
+    std::vector<std::byte> buffer;
+    extract(code, buffer);
+    return io::write(path, {buffer});
+}
+
+void hpprgm::extract(std::span<const std::byte> code, std::vector<std::byte>& out) {
+    stats::Scope scope(stats::Extract);
+    
+    out.reserve(out.size() + 2 + code.size());
+    out.push_back(std::byte{0xFF});
+    out.push_back(std::byte{0xFE});
+    for (size_t i = 0; i + 1 < code.size(); i += 2) {
+        if (code[i] == std::byte{'\r'} && code[i + 1] == std::byte{0}) continue;
+        out.push_back(code[i]);
+        out.push_back(code[i + 1]);
     }
+}
+
 
-    uint16_t u16;
-    while (is.read(reinterpret_cast<char*>(&u16), sizeof(u16))) {
-        if (u16 == 0x009B) {
-            is.read(reinterpret_cast<char*>(&u16), sizeof(u16));
-            if (u16 != 0x00C0) continue;
-            is.seekg(-2, std::ios::cur);
-            wstr = utf::read(is, utf::BOMnone);
-            is.close();
+bool hpprgm::holdsValues(std::span<const std::byte> data) {
+    // Checked on every extraction, so this reads the variable count rather than parse the header.
+    return isG1(data) && u32(data, 0) >= 6 && u16(data, 4) > 0;
+}
+
+
+std::string_view hpprgm::describe(Error error) {
+    switch (error) {
+        case Error::UnknownFormat: return "not a G1 or G2 container, or UTF-8 or UTF-16 text";
+        case Error::NoCode: return "no PPL code found";
+        case Error::BufferTooSmall: return "output buffer too small";
+    }
+    return "unknown error";
+}
+
+std::expected<std::u16string, hpprgm::Error> hpprgm::load(std::span<const std::byte> data) {
+    Header header;
+    return load(data, header);
+}
+
+std::expected<std::u16string, hpprgm::Error> hpprgm::load(std::span<const std::byte> data, Header& header) {
+    return load(data, detect::sniff(data).format, header);
+}
+
+std::expected<std::u16string, hpprgm::Error> hpprgm::load(std::span<const std::byte> data, detect::Format format, Header& header) {
+    static const std::byte utf8[] = {std::byte{0xEF}, std::byte{0xBB}, std::byte{0xBF}};
+    std::u16string str;
+    
+    header.clear();
+    switch (format) {
+        case detect::Format::G1:
+            // The sniffer only saw the prefix, so the sizes are checked in full here.
+            if (!isG1(data)) return std::unexpected(Error::UnknownFormat);
+            header.parse(data);
+            str = extractPPLCode(data);
+            restore(str, header);
+            break;
+            
+        case detect::Format::G2:
+            if (!isG2(data)) return std::unexpected(Error::UnknownFormat);
+            str = extractPPLCode(data);
+            break;
+            
+        case detect::Format::UTF16LE:
+        case detect::Format::UTF16BE: {
+            utf::BOM bom = format == detect::Format::UTF16BE ? utf::BOMbe : utf::BOMle;
+            bool marked = data.size() >= 2 && data[0] == std::byte{bom == utf::BOMbe ? uint8_t{0xFE} : uint8_t{0xFF}} &&
+                                              data[1] == std::byte{bom == utf::BOMbe ? uint8_t{0xFF} : uint8_t{0xFE}};
             
-            return wstr;
+            // Text with a byte order mark and nothing after it is an empty program, not U+FEFF.
+            if (marked) {
+                str = utf::read(data, bom);
+            } else {
+                stats::Scope scope(stats::Transcode);
+                str = utf::decode(data, bom);
+            }
+            break;
         }
+            
+        case detect::Format::UTF8: {
+            if (data.size() >= 3 && std::equal(std::begin(utf8), std::end(utf8), data.begin())) data = data.subspan(3);
+            str = utf::utf16(std::string_view(reinterpret_cast<const char*>(data.data()), data.size()));
+            break;
+        }
+            
+        case detect::Format::Unknown:
+            return std::unexpected(Error::UnknownFormat);
     }
-
-    return wstr;
+    
+    if (str.empty()) return std::unexpected(Error::NoCode);
+    return str;
 }
 
 
-std::wstring hpprgm::load(const std::filesystem::path& path) {
-    std::wstring wstr;
+std::u16string hpprgm::load(const std::filesystem::path& path) {
+    Header header;
+    return load(path, header);
+}
+
+std::u16string hpprgm::load(const std::filesystem::path& path, Header& header) {
+    io::MappedFile file;
     
-    if (!std::filesystem::exists(path)) return wstr;
+    header.clear();
+    if (!file.open(path)) return std::u16string();
     
-    if (path.extension() == ".prgm") wstr = utf::load(path, utf::BOMle);
-    if (path.extension() == ".hpprgm" || path.extension() == ".hpappprgm") {
-        if (isG2(path) || isG1(path)) wstr = extractPPLCode(path);
-    }
-    return wstr;
+    // The mapping is the probe; the extension only weighs in on close calls.
+    return load(file.bytes(), detect::sniff(file.bytes(), path).format, header).value_or(std::u16string());
 }
 
 
-bool hpprgm::save(const std::filesystem::path& path, const std::string& str) {
+// MARK: - Writing
+
+namespace {
+    struct Export {
+        std::u16string_view name;
+        uint16_t arguments;
+    };
+    
+    /**
+     Appends little-endian fields to a buffer that has already been sized
+     for the whole file.
+     */
+    struct Writer {
+        std::byte* at;
+        
+        void u16(uint16_t value) {
+            *at++ = static_cast<std::byte>(value);
+            *at++ = static_cast<std::byte>(value >> 8);
+        }
+        
+        void u32(uint32_t value) {
+            u16(static_cast<uint16_t>(value));
+            u16(static_cast<uint16_t>(value >> 16));
+        }
+        
+        // Names occupy a fixed 64-byte, zero padded field.
+        void name(std::u16string_view name) {
+            name = name.substr(0, 31);
+            for (char16_t ch : name) u16(ch);
+            for (size_t i = name.size(); i < 32; ++i) u16(0);
+        }
+        
+        void fill(std::byte value, size_t count) {
+            std::memset(at, static_cast<int>(value), count);
+            at += count;
+        }
+    };
+}
+
+static bool isIdentifier(char16_t ch) {
+    return ch == '_' || (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+/*
+ The G2 container lists every exported function with its number of
+ arguments, so pick out the lines that start with EXPORT name(...).
+ 
+ The list is kept in a per-thread buffer so repeated saves do not allocate,
+ and is only valid until the next call on the same thread.
+ */
+static const std::vector<Export>& exportedFunctions(std::u16string_view code) {
+    static thread_local std::vector<Export> exports;
+    size_t pos = 0;
+    
+    exports.clear();
     
-    std::ofstream outfile;
-    outfile.open(path, std::ios::out | std::ios::binary);
-    if(!outfile.is_open()) {
-        return false;
+    while (pos < code.size()) {
+        size_t end = code.find(u'\n', pos);
+        if (end == std::u16string_view::npos) end = code.size();
+        
+        std::u16string_view line = code.substr(pos, end - pos);
+        pos = end + 1;
+        
+        size_t i = line.find_first_not_of(u" \t");
+        if (i == std::u16string_view::npos || line.substr(i, 6) != u"EXPORT") continue;
+        if (i + 6 < line.size() && isIdentifier(line[i + 6])) continue;
+        
+        i = line.find_first_not_of(u" \t", i + 6);
+        if (i == std::u16string_view::npos || !isIdentifier(line[i])) continue;
+        
+        size_t first = i;
+        while (i < line.size() && isIdentifier(line[i])) i++;
+        std::u16string_view name = line.substr(first, i - first);
+        
+        i = line.find_first_not_of(u" \t", i);
+        if (i == std::u16string_view::npos || line[i] != '(') continue;
+        
+        size_t close = line.find(u')', i);
+        if (close == std::u16string_view::npos) continue;
+        
+        std::u16string_view parameters = line.substr(i + 1, close - i - 1);
+        uint16_t arguments = 0;
+        if (parameters.find_first_not_of(u" \t") != std::u16string_view::npos) {
+            arguments = 1 + static_cast<uint16_t>(std::count(parameters.begin(), parameters.end(), u','));
+        }
+        exports.push_back({name, arguments});
     }
     
+    return exports;
+}
+
+static size_t g1Capacity(std::u16string_view str, const hpprgm::Header& header) {
+    return header.size() + 4 + str.size() * 2 + 4;
+}
+
+static std::byte* writeG1(std::byte* at, std::u16string_view str, const hpprgm::Header& header) {
     // HEADER
     /**
      0x0000-0x0003: Header Size, excludes itself (so the header begins at offset 4)
-     */
-    outfile.put(0x0C); // 12
-    outfile.put(0x00);
-    outfile.put(0x00);
-    outfile.put(0x00);
-    
-    // Write the 12-byte UTF-16LE header.
-    /**
      0x0004-0x0005: Number of variables in table.
      0x0006-0x0007: Number of uknown?
      0x0008-0x0009: Number of exported functions in table.
      0x000A-0x000F: Conn. kit generates 7F 01 00 00 00 00 but all zeros seems to work too.
+     0x0010-0x----: Entry table, then one value block per variable.
      */
-    for (int i = 0; i < 12 + 4; ++i) {
-        outfile.put(0x00);
-    }
+    std::byte* size = header.write(at);
     
     /**
+     0x0000-0x0003: Size of the PPL Code in UTF-16 LE, patched once written
      0x0004-0x----: Code in UTF-16 LE until 00 00
      */
-    std::wstring wstr = utf::utf16(str);
-    wstr += '\0';
-    uint32_t size = (uint32_t)utf::write(outfile, wstr, utf::BOMnone);
+    Writer out{size + 4};
+    out.at = utf::encode(str, out.at, utf::BOMnone);
     
-    outfile.put(0x00);
-    outfile.put(0x00);
+    // The code is terminated by 00 00, followed by a further 00 00.
+    out.u16(0);
+    Writer{size}.u32(static_cast<uint32_t>(out.at - (size + 4)));
+    out.u16(0);
     
-    outfile.seekp(16, std::ios::beg);
-    outfile.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    outfile.seekp(std::ios::end);
+    return out.at;
+}
+
+/*
+ Layout as found in files written by the G2 Connectivity Kit, a sequence of
+ size-prefixed records (sizes exclude themselves):
+ 
+   7C 61 8A B2  FE FF FF FF  00 00 00 00       signature
+   [8]  05 FF 7F 00 00 00 00 00
+   [8]  05 FF 3F 02 00 00 00 00
+   [8]  05 FF BF 00 <exports> 00 00
+   [..] 3E 02 00 01, then per export:
+          [0x54] [0x44] 0B 02 40 00 <name:64>  [8] 05 02 80 00 <args << 4 | 9> 00 00
+   [..] BE 00 40 01 [..]
+          [0x44] 8B 00 40 00 <program name:64>
+          [8]    85 00 80 00 00 00 00 00
+          [..]   9B 00 C0 00 <code> 00 00
+   [0x3EC] 8E 02 40 02, then ten empty slots:
+          [0x60] [0x44] 8B 02 40 00 <zeros:64>  [0x14] 86 02 80 00 <FF:16>
+ */
+static constexpr uint8_t G2Preamble[] = {
+    0x7C, 0x61, 0x8A, 0xB2, 0xFE, 0xFF, 0xFF, 0xFF, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x00, 0x00, 0x05, 0xFF, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x08, 0x00, 0x00, 0x00, 0x05, 0xFF, 0x3F, 0x02, 0x00, 0x00, 0x00, 0x00
+};
+static constexpr size_t G2ExportSize = 4 + 0x54;
+static constexpr size_t G2SlotSize = 4 + 0x60;
+static constexpr size_t G2Slots = 10;
+
+// Sized as if no carriage returns are dropped from the code.
+static size_t g2Capacity(std::u16string_view str, const std::vector<Export>& exports) {
+    return sizeof(G2Preamble) + 12 + 8 + exports.size() * G2ExportSize
+         + 12 + 0x48 + 12 + 8 + str.size() * 2 + 2
+         + 8 + G2Slots * G2SlotSize;
+}
+
+static std::byte* writeG2(std::byte* at, std::u16string_view str, std::u16string_view name, const std::vector<Export>& exports) {
+    Writer out{at};
+    
+    std::memcpy(out.at, G2Preamble, sizeof(G2Preamble));
+    out.at += sizeof(G2Preamble);
     
-    outfile.close();
-    return true;
+    out.u32(8);
+    out.u32(0x00BFFF05);
+    out.u16(static_cast<uint16_t>(exports.size()));
+    out.u16(0);
+    
+    out.u32(static_cast<uint32_t>(4 + exports.size() * G2ExportSize));
+    out.u32(0x0100023E);
+    for (const auto& entry : exports) {
+        out.u32(0x54);
+        out.u32(0x44);
+        out.u32(0x0040020B);
+        out.name(entry.name);
+        out.u32(8);
+        out.u32(0x00800205);
+        out.u16(static_cast<uint16_t>(entry.arguments << 4 | 0x09));
+        out.u16(0);
+    }
+    
+    std::byte* program = out.at;
+    out.at += 8 + 4;
+    out.u32(0x44);
+    out.u32(0x0040008B);
+    out.name(name);
+    out.u32(8);
+    out.u32(0x00800085);
+    out.u32(0);
+    
+    std::byte* codeRecord = out.at;
+    out.at += 4;
+    out.u32(0x00C0009B);
+    out.at = utf::encode(str, out.at, utf::BOMnone);
+    out.u16(0);
+    
+    std::byte* end = out.at;
+    Writer patch{codeRecord};
+    patch.u32(static_cast<uint32_t>(end - codeRecord - 4));
+    patch = Writer{program};
+    patch.u32(static_cast<uint32_t>(end - program - 4));
+    patch.u32(0x014000BE);
+    patch.u32(static_cast<uint32_t>(end - program - 12));
+    
+    out.u32(4 + G2Slots * G2SlotSize);
+    out.u32(0x0240028E);
+    for (size_t i = 0; i < G2Slots; ++i) {
+        out.u32(0x60);
+        out.u32(0x44);
+        out.u32(0x0040028B);
+        out.fill(std::byte{0x00}, 64);
+        out.u32(0x14);
+        out.u32(0x00800286);
+        out.fill(std::byte{0xFF}, 16);
+    }
+    
+    return out.at;
 }
 
+// MARK: - In-memory saving
+
+// Shared by every G1 save without exported variables or functions.
+static const hpprgm::Header& emptyHeader() {
+    static const hpprgm::Header header;
+    return header;
+}
+
+size_t hpprgm::capacity(std::u16string_view str, Format format) {
+    if (format == G2) return g2Capacity(str, exportedFunctions(str));
+    return g1Capacity(str, emptyHeader());
+}
+
+size_t hpprgm::capacity(std::u16string_view str, const Header& header) {
+    return g1Capacity(str, header);
+}
+
+std::expected<size_t, hpprgm::Error> hpprgm::save(std::span<std::byte> out, std::u16string_view str, const Header& header) {
+    if (out.size() < g1Capacity(str, header)) return std::unexpected(Error::BufferTooSmall);
+    return writeG1(out.data(), str, header) - out.data();
+}
+
+std::expected<size_t, hpprgm::Error> hpprgm::save(std::span<std::byte> out, std::u16string_view str, Format format, std::u16string_view name) {
+    if (format == G1) return save(out, str, emptyHeader());
+    
+    const auto& exports = exportedFunctions(str);
+    if (out.size() < g2Capacity(str, exports)) return std::unexpected(Error::BufferTooSmall);
+    return writeG2(out.data(), str, name, exports) - out.data();
+}
+
+std::expected<size_t, hpprgm::Error> hpprgm::save(std::vector<std::byte>& out, std::u16string_view str, const Header& header) {
+    size_t offset = out.size();
+    
+    out.resize(offset + g1Capacity(str, header));
+    out.resize(writeG1(out.data() + offset, str, header) - out.data());
+    return out.size() - offset;
+}
+
+std::expected<size_t, hpprgm::Error> hpprgm::save(std::vector<std::byte>& out, std::u16string_view str, Format format, std::u16string_view name) {
+    if (format == G1) return save(out, str, emptyHeader());
+    
+    const auto& exports = exportedFunctions(str);
+    size_t offset = out.size();
+    
+    out.resize(offset + g2Capacity(str, exports));
+    out.resize(writeG2(out.data() + offset, str, name, exports) - out.data());
+    return out.size() - offset;
+}
+
+// MARK: - Saving to files
+
+bool hpprgm::save(const std::filesystem::path& path, std::u16string_view str) {
+    return save(path, str, emptyHeader());
+}
+
+bool hpprgm::save(const std::filesystem::path& path, std::u16string_view str, const Header& header) {
+    stats::Scope scope(stats::Write);
+    std::vector<std::byte> buffer;
+    
+    /*
+     On a little-endian host, code with no carriage returns to drop is
+     already in its on-disk form, so it is handed to writev as a segment of
+     its own between the header and the terminator rather than copied.
+     */
+    if (std::endian::native == std::endian::little && str.find(u'\r') == std::u16string_view::npos) {
+        static const std::byte terminator[4]{};
+        
+        buffer.resize(header.size() + 4);
+        Writer{header.write(buffer.data())}.u32(static_cast<uint32_t>(str.size() * 2 + 2));
+        return io::write(path, {buffer, std::as_bytes(std::span(str)), terminator});
+    }
+    
+    save(buffer, str, header);
+    return io::write(path, {buffer});
+}
+
+bool hpprgm::save(const std::filesystem::path& path, std::u16string_view str, Format format) {
+    if (format == G1) return save(path, str);
+    
+    stats::Scope scope(stats::Write);
+    std::vector<std::byte> buffer;
+    
+    // A G2 container carries the program name, taken from the file name.
+    save(buffer, str, format, utf::utf16(path.stem().string()));
+    return io::write(path, {buffer});
+}
+
+bool hpprgm::save(const std::filesystem::path& path, const std::string& str) {
+    return save(path, utf::utf16(str));
+}
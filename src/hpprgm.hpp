@@ -25,13 +25,91 @@
 #ifndef hpprgm_hpp
 #define hpprgm_hpp
 
+#include <expected>
 #include <fstream>
 #include <sstream>
+#include <span>
+#include <string>
+#include <string_view>
 #include <filesystem>
+#include <vector>
+
+#include "header.hpp"
+#include "detect.hpp"
 
 namespace hpprgm {
-    std::wstring load(const std::filesystem::path& path);
+    enum Format {
+        G1,
+        G2
+    };
+    
+    enum class Error {
+        UnknownFormat,
+        NoCode,
+        BufferTooSmall
+    };
+    
+    std::string_view describe(Error error);
+    
+    std::u16string load(const std::filesystem::path& path);
+    std::u16string load(const std::filesystem::path& path, Header& header);
+    bool save(const std::filesystem::path& path, std::u16string_view str);
+    bool save(const std::filesystem::path& path, std::u16string_view str, const Header& header);
+    bool save(const std::filesystem::path& path, std::u16string_view str, Format format);
     bool save(const std::filesystem::path& path, const std::string& str);
+    
+    // MARK: - In-memory
+    
+    /**
+     Reads the PPL code from a G1 or G2 container, or from UTF-8 or UTF-16
+     text, already held in memory. The format is sniffed from the data
+     unless the caller has already done so.
+     */
+    std::expected<std::u16string, Error> load(std::span<const std::byte> data);
+    std::expected<std::u16string, Error> load(std::span<const std::byte> data, Header& header);
+    std::expected<std::u16string, Error> load(std::span<const std::byte> data, detect::Format format, Header& header);
+    
+    /**
+     True if data is a G1 container whose header lists exported variables,
+     which may hold values. load() writes those back into the code; code()
+     does not.
+     */
+    bool holdsValues(std::span<const std::byte> data);
+    
+    /**
+     An upper bound on the number of bytes save() writes for str, enough to
+     size the output buffer.
+     */
+    size_t capacity(std::u16string_view str, Format format = G1);
+    size_t capacity(std::u16string_view str, const Header& header);
+    
+    /**
+     Writes a container into out and returns the number of bytes used. A G2
+     container carries the program name given, G1 does not.
+     */
+    std::expected<size_t, Error> save(std::span<std::byte> out, std::u16string_view str, Format format = G1, std::u16string_view name = u"Main");
+    std::expected<size_t, Error> save(std::span<std::byte> out, std::u16string_view str, const Header& header);
+    
+    /**
+     As above, but appends to out, growing it as needed.
+     */
+    std::expected<size_t, Error> save(std::vector<std::byte>& out, std::u16string_view str, Format format = G1, std::u16string_view name = u"Main");
+    std::expected<size_t, Error> save(std::vector<std::byte>& out, std::u16string_view str, const Header& header);
+    
+    /**
+     The UTF-16LE code held in a G1 or G2 container, without its terminator,
+     or an empty span if the data is neither.
+     */
+    std::span<const std::byte> code(std::span<const std::byte> data);
+    
+    /**
+     Writes code, as returned by code(), to path as a .prgm file without
+     decoding it.
+     */
+    bool extract(std::span<const std::byte> code, const std::filesystem::path& path);
+    
+    // The same .prgm file appended to out.
+    void extract(std::span<const std::byte> code, std::vector<std::byte>& out);
 }
 
 #endif /* hpprgm_hpp */
@@ -0,0 +1,296 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "io.hpp"
+#include "stats.hpp"
+
+#include <cerrno>
+#include <climits>
+#include <algorithm>
+#include <atomic>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <fstream>
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#endif
+
+static long processId() {
+#ifdef _WIN32
+    return _getpid();
+#else
+    return getpid();
+#endif
+}
+
+std::filesystem::path io::temporary(const std::filesystem::path& path) {
+    static std::atomic<unsigned> count{0};
+    std::filesystem::path temporary = path;
+    
+    temporary += ".tmp." + std::to_string(processId()) + "." + std::to_string(count++);
+    return temporary;
+}
+
+io::MappedFile::MappedFile(const std::filesystem::path& path, Access access) {
+    open(path, access);
+}
+
+io::MappedFile::~MappedFile() {
+    close();
+}
+
+io::MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+io::MappedFile& io::MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this == &other) return *this;
+    
+    close();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_ = std::exchange(other.mapped_, false);
+    open_ = std::exchange(other.open_, false);
+    buffer_ = std::move(other.buffer_);
+    
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool io::MappedFile::open(const std::filesystem::path& path, Access) {
+    stats::Scope scope(stats::Open);
+    close();
+    
+    std::ifstream is(path, std::ios::in | std::ios::binary);
+    if (!is.is_open()) return false;
+    
+    char chunk[65536];
+    while (is.read(chunk, sizeof(chunk)) || is.gcount()) {
+        auto first = reinterpret_cast<const std::byte*>(chunk);
+        buffer_.insert(buffer_.end(), first, first + is.gcount());
+    }
+    
+    data_ = buffer_.data();
+    size_ = buffer_.size();
+    open_ = true;
+    stats::read(size_);
+    return true;
+}
+
+void io::MappedFile::close() {
+    buffer_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    open_ = false;
+}
+
+bool io::write(const std::filesystem::path& path, std::initializer_list<std::span<const std::byte>> segments) {
+    return write(path, std::span<const std::span<const std::byte>>(segments.begin(), segments.size()));
+}
+
+bool io::write(const std::filesystem::path& path, std::span<const std::span<const std::byte>> segments) {
+    stats::Scope scope(stats::Write);
+    std::filesystem::path temporary = io::temporary(path);
+    std::error_code ec;
+    
+    {
+        std::ofstream os(temporary, std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!os.is_open()) return false;
+        
+        for (const auto& segment : segments) {
+            os.write(reinterpret_cast<const char*>(segment.data()), segment.size());
+            stats::wrote(segment.size());
+        }
+        if (!os.flush()) {
+            os.close();
+            std::filesystem::remove(temporary, ec);
+            return false;
+        }
+    }
+    
+    std::filesystem::rename(temporary, path, ec);
+    if (ec) std::filesystem::remove(temporary, ec);
+    return !ec;
+}
+
+#else
+
+bool io::MappedFile::open(const std::filesystem::path& path, Access access) {
+    stats::Scope scope(stats::Open);
+    close();
+    
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    stats::syscall();
+    if (fd < 0) return false;
+    
+    struct stat st;
+    stats::syscall();
+    bool regular = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    if (regular && access != Access::Copy) {
+        size_ = static_cast<size_t>(st.st_size);
+        open_ = true;
+        
+        if (size_ == 0) {
+            ::close(fd);
+            stats::syscall();
+            return true;
+        }
+        
+        void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        stats::syscall();
+        if (addr != MAP_FAILED) {
+            ::close(fd);
+            madvise(addr, size_, access == Access::Random ? MADV_RANDOM : MADV_SEQUENTIAL);
+            stats::syscall(2);
+            stats::read(size_);
+            data_ = static_cast<const std::byte*>(addr);
+            mapped_ = true;
+            return true;
+        }
+        size_ = 0;
+    }
+    
+    // Pipes and devices have no size up front, so grow the buffer as we go.
+    size_t capacity = regular ? std::max<size_t>(static_cast<size_t>(st.st_size) + 1, 65536) : 65536;
+    buffer_.resize(capacity);
+    while (true) {
+        if (size_ == capacity) {
+            capacity *= 2;
+            buffer_.resize(capacity);
+        }
+        ssize_t n = ::read(fd, buffer_.data() + size_, capacity - size_);
+        stats::syscall();
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        size_ += static_cast<size_t>(n);
+    }
+    ::close(fd);
+    stats::syscall();
+    stats::read(size_);
+    
+    buffer_.resize(size_);
+    data_ = buffer_.data();
+    open_ = true;
+    return true;
+}
+
+void io::MappedFile::close() {
+    if (mapped_) {
+        munmap(const_cast<std::byte*>(data_), size_);
+        stats::syscall();
+    }
+    
+    buffer_.clear();
+    data_ = nullptr;
+    size_ = 0;
+    mapped_ = false;
+    open_ = false;
+}
+
+// writev may stop short, so step past whatever it managed and go again.
+static bool writeAll(int fd, std::vector<iovec>& iov) {
+    size_t index = 0;
+    
+    while (index < iov.size()) {
+        ssize_t n = ::writev(fd, iov.data() + index, static_cast<int>(std::min<size_t>(iov.size() - index, IOV_MAX)));
+        stats::syscall();
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        
+        size_t written = static_cast<size_t>(n);
+        stats::wrote(written);
+        while (index < iov.size() && written >= iov[index].iov_len) {
+            written -= iov[index++].iov_len;
+        }
+        if (index < iov.size()) {
+            iov[index].iov_base = static_cast<std::byte*>(iov[index].iov_base) + written;
+            iov[index].iov_len -= written;
+        }
+    }
+    return true;
+}
+
+bool io::write(const std::filesystem::path& path, std::initializer_list<std::span<const std::byte>> segments) {
+    return write(path, std::span<const std::span<const std::byte>>(segments.begin(), segments.size()));
+}
+
+bool io::write(const std::filesystem::path& path, std::span<const std::span<const std::byte>> segments) {
+    stats::Scope scope(stats::Write);
+    std::vector<iovec> iov;
+    
+    for (const auto& segment : segments) {
+        if (segment.empty()) continue;
+        iov.push_back({const_cast<std::byte*>(segment.data()), segment.size()});
+    }
+    
+    /*
+     Pipes, devices such as /dev/stdout and anything reached through a
+     symbolic link are written in place. A regular file is written aside and
+     renamed over the original, so readers never see it half written.
+     */
+    struct stat st;
+    bool exists = ::lstat(path.c_str(), &st) == 0;
+    stats::syscall();
+    if (exists && !S_ISREG(st.st_mode)) {
+        int fd = ::open(path.c_str(), O_WRONLY | O_TRUNC | O_CLOEXEC);
+        stats::syscall();
+        if (fd < 0) return false;
+        
+        bool written = writeAll(fd, iov);
+        stats::syscall();
+        return (::close(fd) == 0) && written;
+    }
+    
+    std::filesystem::path temporary = io::temporary(path);
+    int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+    stats::syscall();
+    if (fd < 0) return false;
+    
+    // Keep the permissions of the file being replaced.
+    if (exists) {
+        fchmod(fd, st.st_mode & 07777);
+        stats::syscall();
+    }
+    
+    bool written = writeAll(fd, iov);
+    written = (::close(fd) == 0) && written;
+    written = written && ::rename(temporary.c_str(), path.c_str()) == 0;
+    stats::syscall(2);
+    
+    if (!written) {
+        ::unlink(temporary.c_str());
+        stats::syscall();
+    }
+    return written;
+}
+
+#endif
@@ -0,0 +1,98 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef io_hpp
+#define io_hpp
+
+#include <span>
+#include <vector>
+#include <cstddef>
+#include <initializer_list>
+#include <filesystem>
+
+namespace io {
+    /**
+     How a mapping is going to be read, so the kernel can read ahead for a
+     front-to-back pass or fetch only the pages touched for random access.
+     Copy reads the file into a private buffer instead of mapping it, for
+     files that may be truncated while in use, which would fault a mapping.
+     */
+    enum class Access {
+        Sequential,
+        Random,
+        Copy
+    };
+    
+    /**
+     Read-only view of a whole file, opened once. Regular files are memory
+     mapped; pipes, character devices and anything else that cannot be mapped
+     are read into a private buffer instead, so callers always see one
+     contiguous, immutable run of bytes.
+     */
+    class MappedFile {
+    public:
+        MappedFile() = default;
+        explicit MappedFile(const std::filesystem::path& path, Access access = Access::Sequential);
+        ~MappedFile();
+        
+        MappedFile(MappedFile&& other) noexcept;
+        MappedFile& operator=(MappedFile&& other) noexcept;
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+        
+        bool open(const std::filesystem::path& path, Access access = Access::Sequential);
+        void close();
+        
+        bool is_open() const { return open_; }
+        bool empty() const { return size_ == 0; }
+        size_t size() const { return size_; }
+        const std::byte* data() const { return data_; }
+        std::span<const std::byte> bytes() const { return {data_, size_}; }
+        
+    private:
+        const std::byte* data_ = nullptr;
+        size_t size_ = 0;
+        bool mapped_ = false;
+        bool open_ = false;
+        std::vector<std::byte> buffer_;
+    };
+    
+    /**
+     Writes the segments to path back to back with as few system calls as
+     possible, replacing any existing file. A regular file is written to a
+     temporary beside it and renamed into place, so a partial file never
+     shows up under its own name. Pipes and devices such as /dev/stdout are
+     written directly.
+     */
+    bool write(const std::filesystem::path& path, std::initializer_list<std::span<const std::byte>> segments);
+    bool write(const std::filesystem::path& path, std::span<const std::span<const std::byte>> segments);
+    
+    /**
+     A name beside path, unique to this process and call, for writing a
+     file aside before renaming it into place.
+     */
+    std::filesystem::path temporary(const std::filesystem::path& path);
+}
+
+#endif /* io_hpp */
@@ -23,16 +23,34 @@
 #include <iostream>
 #include <sstream>
 #include <vector>
+#include <set>
+#include <algorithm>
 #include <regex>
 #include <fstream>
 #include <iomanip>
 #include <filesystem>
+#include <climits>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <optional>
 #include "hpprgm.hpp"
 #include "utf.hpp"
+#include "batch.hpp"
+#include "stats.hpp"
+#include "watch.hpp"
+#include "server.hpp"
+#include "io.hpp"
+#include "archive.hpp"
+#include "symbols.hpp"
+#include "search.hpp"
+#include "font.hpp"
+#include "routines.hpp"
+#include "detect.hpp"
+#include "threadpool.hpp"
 
-static bool verbose = false;
-
-// TODO: Impliment "Indices of glyphs"
+static unsigned verbose = 0;
+static stats::Counters totals;
 
 #include "../version_code.h"
 #define NAME "HP Prime Program Tool"
@@ -59,19 +77,104 @@ void help(void) {
     << "Copyright (C) 2024-" << YEAR << " Insoft.\n"
     << "Insoft "<< NAME << " version, " << VERSION_NUMBER << " (BUILD " << BUNDLE_VERSION << ")\n"
     << "\n"
-    << "Usage: " << COMMAND_NAME << " <input-file> [-o <output-file>] [-v flags]"
-    << ""
-    << "Options:"
-    << "  -o <output-file>   Specify the filename for generated .hpprgm or .prgm file."
-    << "  -v                 Enable verbose output for detailed processing information."
-    << ""
-    << "Verbose Flags:"
-    << "  s                  Size of extracted PPL code in bytes."
-    << ""
-    << "Additional Commands:"
-    << "  " << COMMAND_NAME << " {--version | --help}"
-    << "    --version        Display version information."
-    << "    --help           Show this help message.";
+    << "Usage: " << COMMAND_NAME << " <input-file> [-o <output-file>] [-v flags]\n"
+    << "       " << COMMAND_NAME << " <input-file|directory>... [--manifest <file>] [-o <output-directory>] [-j <threads>] [--io <backend>]\n"
+    << "       " << COMMAND_NAME << " --serve <socket> [-j <threads>]\n"
+    << "       " << COMMAND_NAME << " --connect <socket> <input-file> [-o <output-file>]\n"
+    << "       " << COMMAND_NAME << " --pack <archive> <input-file|directory>... [-j <threads>]\n"
+    << "       " << COMMAND_NAME << " --list <archive>\n"
+    << "       " << COMMAND_NAME << " --unpack <archive> [<name>...] [-o <output-directory>]\n"
+    << "       " << COMMAND_NAME << " --index <index> <input-file|directory>... [-j <threads>]\n"
+    << "       " << COMMAND_NAME << " --find <index> <name>[*]...\n"
+    << "       " << COMMAND_NAME << " --grep <pattern>... [--word] <input-file|directory>... [-j <threads>]\n"
+    << "       " << COMMAND_NAME << " --glyphs <input-file>...\n"
+    << "       " << COMMAND_NAME << " --function <name>... [--keep-index] <input-file>...\n"
+    << "\n"
+    << "Options:\n"
+    << "  -o <output-file>   Specify the filename for generated .hpprgm or .prgm file.\n"
+    << "  -v                 Enable verbose output for detailed processing information.\n"
+    << "  -j <threads>       Number of worker threads used for batch conversion.\n"
+    << "  --g2               Write .hpprgm files in the HP Prime G2 format.\n"
+    << "  --compact          Store exported font lists in the header of G1 .hpprgm files as binary values.\n"
+    << "  --compact-local    As --compact, also exporting LOCAL font lists to store them.\n"
+    << "  --minify           Strip comments and spaces from the code, reporting the bytes saved.\n"
+    << "  --shorten          As --minify, also giving LOCAL variables short names.\n"
+    << "  --cache <dir>      Reuse outputs cached in <dir> for inputs that have not changed.\n"
+    << "  --io <backend>     File I/O for batch conversion: blocking (default) or uring.\n"
+    << "  --watch            Stay running and convert inputs again whenever they change.\n"
+    << "  --serve <socket>   Run as a conversion server listening on a Unix domain socket.\n"
+    << "  --connect <socket> Have the server listening on <socket> do the conversion.\n"
+    << "  --pack <archive>   Pack the inputs into a single indexed archive.\n"
+    << "  --list <archive>   List the programs in an archive.\n"
+    << "  --unpack <archive> Extract all, or the named, programs from an archive.\n"
+    << "  --index <index>    Create or update an index of the names the inputs export.\n"
+    << "  --find <index>     Show which programs export a name, or names starting with it when followed by *.\n"
+    << "  --grep <pattern>   Show the lines of PPL code that contain <pattern>; may be given more than once.\n"
+    << "  --word             Only match --grep patterns that are whole identifiers.\n"
+    << "  --glyphs           List the glyphs of each font in the inputs.\n"
+    << "  --function <name>  Print the routine <name> from each input without reading the rest of the code.\n"
+    << "  --keep-index       Save the routine index used by --function beside each input as <file>.routines.\n"
+    << "  --manifest <file>  Read additional input paths from <file>, one per line.\n"
+    << "\n"
+    << "Verbose Flags:\n"
+    << "  s                  Size of extracted PPL code in bytes.\n"
+    << "  t                  Time spent opening, detecting, extracting, transcoding and writing.\n"
+    << "  c                  Bytes read and written, code units, allocations and system calls.\n"
+    << "  j                  Report everything as one line of JSON per file.\n"
+    << "\n"
+    << "Additional Commands:\n"
+    << "  " << COMMAND_NAME << " {--version | --help}\n"
+    << "    --version        Display version information.\n"
+    << "    --help           Show this help message.\n";
+}
+
+// MARK: - Instrumentation
+
+// Once inlined, GCC takes these replacements for a malloc/delete mismatch.
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+
+void* operator new(size_t size) {
+    stats::allocation();
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+#pragma GCC diagnostic pop
+
+static unsigned verboseFlags(const std::string& flags) {
+    unsigned report = 0;
+    
+    for (char flag : flags) {
+        if (flag == 's') report |= stats::Size;
+        if (flag == 't') report |= stats::Timing;
+        if (flag == 'c') report |= stats::Counts;
+        if (flag == 'j') report |= stats::JSON;
+    }
+    
+    // Without any particular flags, report everything.
+    if (!(report & (stats::Size | stats::Timing | stats::Counts))) report |= stats::Size | stats::Timing | stats::Counts;
+    return report;
 }
 
 // MARK: - Extensions
@@ -126,7 +229,7 @@ namespace std::filesystem {
     #error "C++11 or newer is required"
 #endif
 
-fs::path resolveAndValidateInputFile(const char *input_file) {
+fs::path resolveInputFile(const char *input_file) {
     fs::path path;
     
     path = input_file;
@@ -135,10 +238,20 @@ fs::path resolveAndValidateInputFile(const char *input_file) {
     path = fs::expand_tilde(path);
     if (path.parent_path().empty()) path = fs::path("./") / path;
     
-    // • Applies a default extension
-    if (path.extension().empty()) path.replace_extension("hpprgm");
+    // • Applies a default extension, unless the file exists as named and its contents say what it is
+    std::error_code ec;
+    if (path.extension().empty() && !fs::exists(path, ec)) path.replace_extension("hpprgm");
     
-    if (!fs::exists(path)) {
+    return path;
+}
+
+fs::path resolveAndValidateInputFile(const char *input_file) {
+    fs::path path = resolveInputFile(input_file);
+    
+    if (path == "/dev/stdin") return path;
+    
+    std::error_code ec;
+    if (!fs::exists(path, ec)) {
         std::cerr << "❓File " << path.filename() << " not found at " << path.parent_path() << " location.\n";
         exit(0);
     }
@@ -157,19 +270,421 @@ fs::path resolveOutputFile(const char *output_file) {
     return path;
 }
 
+// Without an extension to go by, the first few bytes of the input decide.
+static bool isContainer(const fs::path& inpath) {
+    if (!inpath.extension().empty() || inpath == "/dev/stdin") return inpath.extension() == ".hpprgm";
+    return detect::isContainer(detect::sniff(inpath).format);
+}
+
 fs::path resolveOutputPath(const fs::path& inpath, const fs::path& outpath) {
     fs::path path = outpath;
     
     if (path == "/dev/stdout") return path;
     
     if (path.empty()) path = inpath;
-    if (fs::is_directory(path)) path = path / inpath.filename();
-    path.replace_extension((inpath.extension() == ".hpprgm" ? "prgm" : "hpprgm"));
+    std::error_code ec;
+    if (fs::is_directory(path, ec)) path = path / inpath.filename();
+    path.replace_extension((isContainer(inpath) ? "prgm" : "hpprgm"));
     if (path.parent_path().empty()) path = inpath.parent_path() / path;
     
     return path;
 }
 
+// MARK: - Batch
+
+static bool isProgramFile(const fs::path& path) {
+    return path.extension() == ".hpprgm" || path.extension() == ".hpappprgm" || path.extension() == ".prgm";
+}
+
+static void collectInputs(const fs::path& path, std::vector<fs::path>& inputs) {
+    std::error_code ec;
+    
+    // A path that cannot even be queried still becomes a job, which then reports it.
+    if (!fs::is_directory(path, ec)) {
+        inputs.push_back(path);
+        return;
+    }
+    
+    for (auto it = fs::recursive_directory_iterator(path, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        if (ec) break;
+        if (it->is_regular_file(ec) && isProgramFile(it->path())) inputs.push_back(it->path());
+    }
+}
+
+static void collectManifest(const fs::path& manifest, std::vector<fs::path>& inputs) {
+    std::ifstream is(manifest);
+    std::string line;
+    
+    if (!is.is_open()) {
+        std::cerr << "❓File " << manifest.filename() << " not found at " << manifest.parent_path() << " location.\n";
+        exit(0);
+    }
+    
+    while (std::getline(is, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line.front() == '#') continue;
+        collectInputs(resolveInputFile(line.c_str()), inputs);
+    }
+}
+
+static void report(const batch::Result& result) {
+    if (!result.message.empty()) std::cerr << result.message << "\n";
+    if (!verbose) return;
+    
+    stats::print(std::cerr, result.inpath, result.counters, verbose);
+    totals += result.counters;
+}
+
+/*
+ options holds the settings shared by every job, its paths being filled in
+ for each input.
+ */
+static batch::Job makeJob(const batch::Job& options, const fs::path& inpath, const fs::path& outpath) {
+    batch::Job job = options;
+    
+    job.inpath = inpath;
+    job.outpath = outpath;
+    return job;
+}
+
+// The canonical form of path, or path itself if it cannot be resolved.
+static fs::path identity(const fs::path& path) {
+    std::error_code ec;
+    fs::path canonical = fs::weakly_canonical(path, ec);
+    return ec ? path : canonical;
+}
+
+static int runBatch(const std::vector<fs::path>& inputs, const fs::path& outpath, unsigned threads, const batch::Job& options, aio::Backend backend) {
+    std::vector<batch::Job> jobs;
+    std::vector<batch::Result> skipped;
+    
+    if (outpath == "/dev/stdout" || (!outpath.empty() && !fs::is_directory(outpath))) {
+        std::cerr << "❌ Output for multiple inputs must be an existing directory.\n";
+        return 0;
+    }
+    
+    for (const auto& inpath : inputs) {
+        jobs.push_back(makeJob(options, inpath, resolveOutputPath(inpath, outpath)));
+    }
+    
+    /*
+     A directory holding both Name.prgm and Name.hpprgm would have each file
+     overwrite the other while it is still being read, so any job whose output
+     is also an input (or the output of an earlier job) is skipped.
+     */
+    std::set<fs::path> claimed;
+    for (const auto& job : jobs) claimed.insert(identity(job.inpath));
+    
+    std::vector<batch::Job> runnable;
+    for (const auto& job : jobs) {
+        auto target = identity(job.outpath);
+        if (claimed.contains(target)) {
+            std::ostringstream os;
+            os << "⚠️ Skipped " << job.inpath.filename() << ", output " << job.outpath.filename() << " conflicts with another input.";
+            skipped.push_back({job.inpath, job.outpath, false, os.str(), {}});
+            continue;
+        }
+        claimed.insert(target);
+        runnable.push_back(job);
+    }
+    
+    if (!aio::available(backend)) {
+        std::cerr << "⚠️ The " << aio::describe(backend) << " backend is not available, using " << aio::describe(aio::Backend::Blocking) << ".\n";
+    }
+    
+    for (const auto& result : skipped) report(result);
+    auto results = batch::run(runnable, threads, report, backend);
+    
+    size_t failed = skipped.size();
+    for (const auto& result : results) {
+        if (!result.success) failed++;
+    }
+    
+    std::cerr << "Converted " << jobs.size() - failed << " of " << jobs.size() << " files.\n";
+    if (verbose) stats::print(std::cerr, fs::path(), totals, verbose);
+    return 0;
+}
+
+static int runWatch(const std::vector<fs::path>& paths, const fs::path& outpath, unsigned threads, const batch::Job& options) {
+    bool many = paths.size() > 1 || std::any_of(paths.begin(), paths.end(), [](const fs::path& path) { return fs::is_directory(path); });
+    
+    if (outpath == "/dev/stdout" || (many && !outpath.empty() && !fs::is_directory(outpath))) {
+        std::cerr << "❌ Output for multiple inputs must be an existing directory.\n";
+        return 0;
+    }
+    
+    auto resolve = [&](const fs::path& inpath) -> std::optional<batch::Job> {
+        if (!isProgramFile(inpath)) return std::nullopt;
+        return makeJob(options, inpath, resolveOutputPath(inpath, outpath));
+    };
+    
+    std::cerr << "Watching for changes, press Ctrl+C to stop.\n";
+    if (!watch::run(paths, resolve, threads, report)) {
+        std::cerr << "❌ Unable to watch for changes.\n";
+    }
+    return 0;
+}
+
+// MARK: - Server
+
+static int runServer(const fs::path& socket, unsigned threads) {
+    std::string error;
+    
+    if (!server::serve(socket, threads, error)) {
+        std::cerr << "❌ Unable to listen on " << socket << ": " << error << ".\n";
+    }
+    return 0;
+}
+
+static int runClient(const fs::path& socket, const fs::path& inpath, const fs::path& outpath, hpprgm::Format format) {
+    io::MappedFile file(inpath);
+    std::vector<std::byte> response;
+    std::string error;
+    
+    server::Target target = server::Target::UTF8;
+    if (outpath.extension() == ".prgm") target = server::Target::PRGM;
+    if (outpath.extension() == ".hpprgm") target = format == hpprgm::G2 ? server::Target::G2 : server::Target::G1;
+    
+    if (!file.is_open()) {
+        std::cerr << "❌ Unable to read " << inpath.filename() << ".\n";
+        return 0;
+    }
+    
+    if (!server::request(socket, server::Source::Bytes, target, outpath.stem().string(), file.bytes(), response, error)) {
+        std::cerr << "❌ " << error << ".\n";
+        return 0;
+    }
+    
+    if (!io::write(outpath, {response})) {
+        std::cerr << "❌ Unable to create file " << outpath.filename() << ".\n";
+        return 0;
+    }
+    
+    if (outpath != "/dev/stdout") std::cerr << "✅ File " << outpath.filename() << " succefuly created.\n";
+    return 0;
+}
+
+// MARK: - Archive
+
+static int runPack(const fs::path& path, const std::vector<fs::path>& roots, unsigned threads) {
+    std::vector<archive::Input> members;
+    
+    // Programs found in a directory keep their path relative to it.
+    for (const auto& root : roots) {
+        if (!fs::is_directory(root)) {
+            members.push_back({root.filename().string(), root});
+            continue;
+        }
+        
+        std::vector<fs::path> files;
+        collectInputs(root, files);
+        for (const auto& file : files) members.push_back({fs::relative(file, root).generic_string(), file});
+    }
+    
+    if (members.empty()) error();
+    if (!archive::pack(path, members, threads)) {
+        std::cerr << "❌ Unable to create archive " << path.filename() << ".\n";
+        return 0;
+    }
+    
+    std::cerr << "✅ Packed " << members.size() << " programs into " << path.filename() << ".\n";
+    return 0;
+}
+
+static int runList(const fs::path& path) {
+    archive::Reader reader;
+    
+    if (!reader.open(path)) {
+        std::cerr << "❌ " << path.filename() << " is not an archive.\n";
+        return 0;
+    }
+    
+    for (const auto& member : reader.members()) {
+        std::cout << std::setw(10) << member.size << "  " << std::left << std::setw(5) << archive::describe(member.format) << std::right
+                  << "  " << std::hex << std::setw(16) << std::setfill('0') << member.checksum << std::dec << std::setfill(' ')
+                  << "  " << member.name << "\n";
+    }
+    return 0;
+}
+
+static int runUnpack(const fs::path& path, const std::vector<std::string>& names, const fs::path& outdir) {
+    archive::Reader reader;
+    std::vector<const archive::Member*> members;
+    
+    if (!reader.open(path)) {
+        std::cerr << "❌ " << path.filename() << " is not an archive.\n";
+        return 0;
+    }
+    
+    for (const auto& member : reader.members()) {
+        if (names.empty()) members.push_back(&member);
+    }
+    for (const auto& name : names) {
+        const archive::Member* member = reader.find(name);
+        if (!member) {
+            std::cerr << "❓No program \"" << name << "\" in " << path.filename() << ".\n";
+            continue;
+        }
+        members.push_back(member);
+    }
+    
+    for (const auto* member : members) {
+        fs::path name(member->name);
+        
+        // Never write outside the output directory.
+        if (name.is_absolute() || std::find(name.begin(), name.end(), "..") != name.end()) {
+            std::cerr << "❌ Skipped " << name << ", it would be written outside the output directory.\n";
+            continue;
+        }
+        
+        if (!reader.verify(*member)) {
+            std::cerr << "❌ Checksum mismatch for " << name << ".\n";
+            continue;
+        }
+        
+        fs::path target = outdir / name;
+        std::error_code ec;
+        fs::create_directories(target.parent_path(), ec);
+        if (!io::write(target, {reader.bytes(*member)})) {
+            std::cerr << "❌ Unable to create file " << target.filename() << ".\n";
+            continue;
+        }
+        std::cerr << "✅ File " << target.filename() << " succefuly created.\n";
+    }
+    return 0;
+}
+
+// MARK: - Symbols
+
+static int runIndex(const fs::path& path, const std::vector<fs::path>& inputs, unsigned threads) {
+    symbols::Summary summary;
+    
+    if (inputs.empty()) error();
+    if (!symbols::update(path, inputs, threads, summary)) {
+        std::cerr << "❌ Unable to create index " << path.filename() << ".\n";
+        return 0;
+    }
+    
+    std::cerr << "✅ Indexed " << summary.symbols << " names from " << summary.files << " programs, "
+              << summary.scanned << " scanned.\n";
+    return 0;
+}
+
+static int runFind(const fs::path& path, const std::vector<std::string>& names) {
+    symbols::Index index;
+    
+    if (!index.open(path)) {
+        std::cerr << "❌ " << path.filename() << " is not an index.\n";
+        return 0;
+    }
+    
+    for (const auto& name : names) {
+        bool prefix = name.ends_with('*');
+        auto [first, last] = index.find(prefix ? std::string_view(name).substr(0, name.size() - 1) : std::string_view(name), prefix);
+        
+        if (first == last) std::cerr << "❓No program exports \"" << name << "\".\n";
+        for (size_t i = first; i < last; ++i) {
+            symbols::Entry entry = index.symbol(i);
+            if (entry.file >= index.files()) continue;
+            std::cout << (entry.kind == symbols::Function ? "function  " : "variable  ") << entry.name << "  " << index.file(entry.file).path << "\n";
+        }
+    }
+    return 0;
+}
+
+// MARK: - Search
+
+static int runGrep(const std::vector<std::u16string>& patterns, bool words, const std::vector<fs::path>& inputs, unsigned threads) {
+    const search::Matcher matcher(patterns, words);
+    std::vector<std::vector<search::Line>> found(inputs.size());
+    
+    if (inputs.empty()) error();
+    {
+        ThreadPool pool(threads);
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            pool.submit([&, i] {
+                io::MappedFile mapped;
+                if (!mapped.open(inputs[i])) return;
+                
+                // Containers are searched in place, as are .prgm files saved as UTF-16LE.
+                found[i] = search::grep(routines::code(mapped.bytes()), matcher);
+            });
+        }
+        pool.wait();
+    }
+    
+    for (size_t i = 0; i < inputs.size(); ++i) {
+        for (const auto& line : found[i]) {
+            std::cout << inputs[i].string() << ":" << line.number << ": " << line.text << "\n";
+        }
+    }
+    return 0;
+}
+
+// MARK: - Fonts
+
+static int runGlyphs(const std::vector<fs::path>& inputs) {
+    if (inputs.empty()) error();
+    
+    for (const auto& path : inputs) {
+        std::u16string str = hpprgm::load(path);
+        auto fonts = font::parse(str);
+        
+        if (fonts.empty()) {
+            std::cerr << "❓No fonts in " << path.filename() << ".\n";
+            continue;
+        }
+        
+        for (const auto& font : fonts) {
+            std::cout << path.filename().string() << ": " << (font.name.empty() ? "(unnamed)" : utf::utf8(font.name))
+                      << ", " << font.bitmap.size() * 8 << " bitmap bytes, glyphs " << font.first << "-" << font.last
+                      << ", line height " << font.yAdvance << "\n";
+            if (font.glyphs.empty()) {
+                std::cout << "  no glyph table\n";
+                continue;
+            }
+            
+            std::cout << "  code  offset   size  advance   dx   dy\n";
+            for (const auto& glyph : font.glyphs) {
+                std::cout << std::setw(6) << glyph.code << std::setw(8) << glyph.offset
+                          << std::setw(7) << (std::to_string(glyph.width) + "x" + std::to_string(glyph.height))
+                          << std::setw(9) << int(glyph.advance) << std::setw(5) << int(glyph.dx) << std::setw(5) << int(glyph.dy) << "\n";
+            }
+        }
+    }
+    return 0;
+}
+
+// MARK: - Routines
+
+static int runFunctions(const std::vector<std::string>& functions, const std::vector<fs::path>& inputs, bool keep) {
+    if (inputs.empty()) error();
+    
+    for (const auto& path : inputs) {
+        io::MappedFile mapped;
+        if (!mapped.open(path, io::Access::Random)) {
+            std::cerr << "❓File " << path.filename() << " not found at " << path.parent_path() << " location.\n";
+            continue;
+        }
+        
+        auto index = routines::index(path, mapped.bytes(), keep);
+        if (!index) {
+            std::cerr << "❌ Unable extract PPL source code " << path.filename() << ".\n";
+            continue;
+        }
+        
+        for (const auto& name : functions) {
+            const routines::Routine* routine = index->find(name);
+            if (!routine || size_t(index->code) + routine->offset + routine->size > mapped.size()) {
+                std::cerr << "❓Function " << name << " not found in " << path.filename() << ".\n";
+                continue;
+            }
+            std::cout << utf::utf8(utf::decode(mapped.bytes().subspan(index->code + routine->offset, routine->size))) << "\n";
+        }
+    }
+    return 0;
+}
+
 // MARK: - Main
 
 int main(int argc, const char **argv)
@@ -177,6 +692,22 @@ int main(int argc, const char **argv)
     namespace fs = std::filesystem;
     
     fs::path inpath, outpath;
+    std::vector<fs::path> inputs;
+    unsigned threads = std::thread::hardware_concurrency();
+    batch::Job options;
+    std::vector<fs::path> roots;
+    fs::path serve, connect;
+    fs::path pack, list, unpack;
+    fs::path indexpath, findpath;
+    std::vector<std::string> names;
+    std::vector<std::u16string> patterns;
+    bool words = false;
+    bool glyphs = false;
+    std::vector<std::string> functions;
+    bool keep = false;
+    aio::Backend backend = aio::Backend::Blocking;
+    bool many = false;
+    bool watching = false;
     
     if (argc == 1) {
         error();
@@ -206,9 +737,118 @@ int main(int argc, const char **argv)
             }
             
             if (args == "-v") {
-                if (++n > argc) error();
-                args = argv[n];
-                verbose = true;
+                if (++n >= argc) error();
+                verbose = verboseFlags(argv[n]);
+                stats::enable();
+                continue;
+            }
+            
+            if (args == "-j") {
+                if (++n >= argc) error();
+                threads = static_cast<unsigned>(std::max(1, atoi(argv[n])));
+                continue;
+            }
+            
+            if (args == "--g2") {
+                options.format = hpprgm::G2;
+                continue;
+            }
+            
+            if (args == "--compact" || args == "--compact-local") {
+                options.compact = true;
+                options.exportLocal = options.exportLocal || args == "--compact-local";
+                continue;
+            }
+            
+            if (args == "--minify" || args == "--shorten") {
+                options.minify = true;
+                options.shorten = options.shorten || args == "--shorten";
+                continue;
+            }
+            
+            if (args == "--glyphs") {
+                glyphs = true;
+                continue;
+            }
+            
+            if (args == "--cache") {
+                if (++n >= argc) error();
+                options.cache = fs::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--io") {
+                if (++n >= argc) error();
+                auto selected = aio::backend(argv[n]);
+                if (!selected) error();
+                backend = *selected;
+                continue;
+            }
+            
+            if (args == "--serve") {
+                if (++n >= argc) error();
+                serve = fs::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--connect") {
+                if (++n >= argc) error();
+                connect = fs::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--pack" || args == "--list" || args == "--unpack") {
+                if (++n >= argc) error();
+                fs::path& archive = args == "--pack" ? pack : args == "--list" ? list : unpack;
+                archive = fs::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--index") {
+                if (++n >= argc) error();
+                indexpath = fs::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--find") {
+                if (++n >= argc) error();
+                findpath = fs::expand_tilde(argv[n]);
+                continue;
+            }
+            
+            if (args == "--grep") {
+                if (++n >= argc) error();
+                patterns.push_back(utf::utf16(argv[n]));
+                continue;
+            }
+            
+            if (args == "--function") {
+                if (++n >= argc) error();
+                functions.push_back(argv[n]);
+                continue;
+            }
+            
+            if (args == "--keep-index") {
+                keep = true;
+                continue;
+            }
+            
+            if (args == "--word") {
+                words = true;
+                continue;
+            }
+            
+            if (args == "--watch") {
+                watching = true;
+                continue;
+            }
+            
+            if (args == "--manifest") {
+                if (++n >= argc) error();
+                size_t first = inputs.size();
+                collectManifest(resolveInputFile(argv[n]), inputs);
+                roots.insert(roots.end(), inputs.begin() + first, inputs.end());
+                many = true;
                 continue;
             }
             
@@ -216,52 +856,48 @@ int main(int argc, const char **argv)
             return 0;
         }
         
-        inpath = resolveAndValidateInputFile(argv[n]);
+        names.push_back(argv[n]);
+        if (!unpack.empty() || !findpath.empty()) continue;
+        
+        collectInputs(resolveInputFile(argv[n]), inputs);
+        roots.push_back(resolveInputFile(argv[n]));
+        std::error_code ec;
+        if (fs::is_directory(resolveInputFile(argv[n]), ec)) many = true;
     }
     
-    outpath = resolveOutputPath(inpath, outpath);
-    
-    std::ifstream infile;
+    if (!serve.empty()) return runServer(serve, threads);
+    if (!list.empty()) return runList(list);
+    if (!unpack.empty()) return runUnpack(unpack, names, outpath.empty() ? fs::path(".") : outpath);
+    if (!pack.empty()) return runPack(pack, roots, threads);
+    if (!findpath.empty()) return runFind(findpath, names);
+    if (!indexpath.empty()) return runIndex(indexpath, inputs, threads);
+    if (!patterns.empty()) return runGrep(patterns, words, inputs, threads);
+    if (glyphs) return runGlyphs(inputs);
+    if (!functions.empty()) return runFunctions(functions, inputs, keep);
     
-    infile.open(inpath, std::ios::in | std::ios::binary);
-
-    if (!infile.is_open()) {
-        std::cerr << "❓File " << inpath.filename() << " not found at " << inpath.parent_path() << " location.\n";
-        exit(0);
+    if (watching) {
+        if (roots.empty()) error();
+        return runWatch(roots, outpath, threads, options);
     }
     
-    std::wstring wstr;
-    
-    if (inpath.extension() == ".hpprgm" || inpath.extension() == ".hpappprgm") {
-        wstr = hpprgm::load(inpath);
-    } else {
-        wstr = utf::load(inpath, utf::BOMle);
+    if (many || inputs.size() > 1) {
+        return runBatch(inputs, outpath, threads, options, backend);
     }
     
-    if (wstr.empty()) {
-        if (!std::filesystem::exists(outpath)) {
-            std::cerr << "❌ Unable extract PPL source code " << inpath.filename() << ".\n";
-            return 0;
-        }
-        return 0;
-    }
+    if (inputs.empty()) error();
+    inpath = resolveAndValidateInputFile(inputs.front().c_str());
+    outpath = resolveOutputPath(inpath, outpath);
     
-    if (outpath == "/dev/stdout") {
-        std::cout << utf::utf8(wstr);
-    } else {
-        if (outpath.extension() == ".hpprgm") {
-            hpprgm::save(outpath, utf::utf8(wstr));
-        } else {
-            utf::save(outpath, wstr);
-        }
-    }
+    if (!connect.empty()) return runClient(connect, inpath, outpath, options.format);
     
-    if (!std::filesystem::exists(outpath)) {
-        std::cerr << "❌ Unable to create file " << outpath.filename() << ".\n";
+    // Standard output only ever gets text, which has no header to compact fonts into.
+    if (outpath == "/dev/stdout" && options.compact) {
+        std::cerr << "❌ --compact needs a .hpprgm output, not standard output.\n";
         return 0;
     }
-
-    std::cerr << "✅ File " << outpath.filename() << " succefuly created.\n";
+    
+    auto result = batch::convert(makeJob(options, inpath, outpath));
+    report(result);
     
     return 0;
 }
@@ -0,0 +1,447 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "minify.hpp"
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+using namespace minify;
+
+static bool isSpace(char16_t ch) {
+    return ch == ' ' || ch == '\t' || ch == '\n' || ch == '\r' || ch == 0xFEFF;
+}
+
+static bool isDigit(char16_t ch) {
+    return ch >= '0' && ch <= '9';
+}
+
+static bool isOperatorSymbol(char16_t ch) {
+    switch (ch) {
+        case u'≠': case u'≤': case u'≥': case u'▶': case u'→': case u'√':
+        case u'²': case u'³': case u'×': case u'÷': case u'−': case u'∡':
+            return true;
+            
+        default:
+            return false;
+    }
+}
+
+// Anything beyond ASCII that is not an operator counts as a letter, as with π and θ.
+static bool isLetter(char16_t ch) {
+    return ch == '_' || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z') || (ch >= 0x80 && !isOperatorSymbol(ch));
+}
+
+static bool isIdentifier(char16_t ch) {
+    return isLetter(ch) || isDigit(ch);
+}
+
+namespace {
+    enum Class {
+        Word,       // Letters, digits, strings and literals, which would run into one another.
+        Operator,   // Symbols such as - and =, which could pair up as -- or <=.
+        Separator   // Brackets, commas and semicolons, which never need a space.
+    };
+    
+    constexpr uint32_t Keep = UINT32_MAX;
+    
+    /*
+     Short names are a letter followed by a number: a0 to z0, then a1 and so
+     on. A name of that form in the source maps back to the same index, so
+     it can be marked as taken.
+     */
+    size_t generate(uint32_t index, char16_t* out) {
+        char16_t digits[10];
+        size_t count = 0;
+        uint32_t number = index / 26;
+        
+        do {
+            digits[count++] = static_cast<char16_t>(u'0' + number % 10);
+            number /= 10;
+        } while (number);
+        
+        out[0] = static_cast<char16_t>(u'a' + index % 26);
+        for (size_t i = 0; i < count; ++i) out[i + 1] = digits[count - 1 - i];
+        return count + 1;
+    }
+    
+    uint32_t generated(std::u16string_view name) {
+        if (name.size() < 2 || name.size() > 8 || name[0] < 'a' || name[0] > 'z') return Keep;
+        if (name[1] == '0' && name.size() > 2) return Keep;
+        
+        uint32_t number = 0;
+        for (size_t i = 1; i < name.size(); ++i) {
+            if (!isDigit(name[i])) return Keep;
+            number = number * 10 + (name[i] - '0');
+        }
+        return number * 26 + (name[0] - 'a');
+    }
+    
+    struct Name {
+        std::u16string_view source;
+        uint32_t index;
+    };
+    
+    class Minifier {
+    public:
+        Minifier(std::u16string_view code, bool shorten) : code_(code), shorten_(shorten) {
+            out_.reserve(code.size());
+            if (shorten) names_.reserve(64);
+        }
+        
+        std::u16string run() {
+            size_t i = 0;
+            
+            while (i < code_.size()) {
+                char16_t ch = code_[i];
+                
+                if (isSpace(ch)) {
+                    if (ch == '\n') lineStart_ = true;
+                    space_ = true;
+                    i++;
+                } else if (ch == '/' && at(i + 1) == '/') {
+                    while (i < code_.size() && code_[i] != '\n') i++;
+                    space_ = true;
+                } else if (ch == '#' && lineStart_ && code_.substr(i, 7) == u"#pragma") {
+                    i = pragma(i);
+                } else if (ch == '"') {
+                    i = string(i);
+                } else if (ch == '#') {
+                    i = literal(i);
+                } else if (isDigit(ch) || (ch == '.' && isDigit(at(i + 1)))) {
+                    i = number(i);
+                } else if (isLetter(ch)) {
+                    i = identifier(i);
+                } else {
+                    punctuation(i++);
+                }
+            }
+            return std::move(out_);
+        }
+        
+        bool clashed() const {
+            return clash_;
+        }
+        
+    private:
+        std::u16string_view code_;
+        std::u16string out_;
+        bool shorten_;
+        
+        bool space_ = false;        // Spaces or comments skipped since the last token.
+        bool newline_ = false;      // The next token has to start a line.
+        bool lineStart_ = true;     // Nothing but spaces so far on this source line.
+        bool comma_ = false;        // ',' is the decimal mark, set by #pragma mode.
+        bool start_ = true;         // At the start of a top-level statement.
+        bool clash_ = false;        // The source used a short name already handed out.
+        
+        /*
+         Names in scope, innermost last. The first global_ were declared
+         outside any function and outlive each function's own.
+         */
+        std::vector<Name> names_;
+        std::vector<bool> taken_;
+        size_t global_ = 0;
+        uint32_t next_ = 0;
+        uint32_t globalNext_ = 0;
+        
+        enum State {
+            Idle,
+            Declaring,      // After LOCAL or a ',' between declarations.
+            Declared,       // After a declared name.
+            Initializing,   // After ':=' in a declaration.
+            Parameters      // In the parameter list of a function definition.
+        };
+        State state_ = Idle;
+        int depth_ = 0;
+        int nesting_ = 0;
+        
+        char16_t at(size_t i) const {
+            return i < code_.size() ? code_[i] : u'\0';
+        }
+        
+        char16_t peek(size_t i) const {
+            while (i < code_.size() && isSpace(code_[i])) i++;
+            return at(i);
+        }
+        
+        Class classify(char16_t ch) const {
+            switch (ch) {
+                case '(': case ')': case '[': case ']': case '{': case '}': case ';': case '\n':
+                    return Separator;
+                    
+                case ',':
+                    return comma_ ? Word : Separator;
+                    
+                case '.': case '#': case '"': case '\'':
+                    return Word;
+                    
+                default:
+                    return isIdentifier(ch) ? Word : Operator;
+            }
+        }
+        
+        void emit(std::u16string_view token) {
+            if (!out_.empty()) {
+                if (newline_) {
+                    if (out_.back() != '\n') out_ += u'\n';
+                } else if (space_) {
+                    Class previous = classify(out_.back());
+                    if (previous != Separator && previous == classify(token.front())) out_ += u' ';
+                }
+            }
+            out_ += token;
+            space_ = newline_ = lineStart_ = start_ = false;
+        }
+        
+        size_t pragma(size_t i) {
+            size_t end = code_.find(u'\n', i);
+            if (end == std::u16string_view::npos) end = code_.size();
+            
+            std::u16string_view line = code_.substr(i, end - i);
+            if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+            
+            // Any separator other than the default changes what ',' means, so names are left alone too.
+            size_t separator = line.find(u"separator(");
+            if (separator != std::u16string_view::npos && line.substr(separator, 14) != u"separator(.,;)") {
+                comma_ = true;
+                shorten_ = false;
+            }
+            
+            newline_ = true;
+            emit(line);
+            newline_ = start_ = true;
+            return end;
+        }
+        
+        size_t string(size_t i) {
+            size_t end = i + 1;
+            
+            while (end < code_.size() && code_[end] != '"') end += code_[end] == '\\' ? 2 : 1;
+            end = std::min(end + 1, code_.size());
+            emit(code_.substr(i, end - i));
+            return end;
+        }
+        
+        // #FFh, #1010b, #XXXXXXXXXXXXXXXX:64h and so on.
+        size_t literal(size_t i) {
+            size_t end = i + 1;
+            
+            while (end < code_.size() && code_[end] < 0x80 && (isIdentifier(code_[end]) || code_[end] == ':')) end++;
+            emit(code_.substr(i, end - i));
+            return end;
+        }
+        
+        // Read whole so that an exponent such as the E5 of 1E5 is not taken for a name.
+        size_t number(size_t i) {
+            size_t end = i;
+            
+            while (end < code_.size() && (isDigit(code_[end]) || code_[end] == '.')) end++;
+            if (at(end) == 'E' || at(end) == 'e' || at(end) == u'ᴇ') {
+                size_t digits = end + 1;
+                if (at(digits) == '+' || at(digits) == '-' || at(digits) == u'−') digits++;
+                if (isDigit(at(digits))) {
+                    end = digits;
+                    while (isDigit(at(end))) end++;
+                }
+            }
+            emit(code_.substr(i, end - i));
+            return end;
+        }
+        
+        size_t identifier(size_t i) {
+            size_t end = i;
+            
+            while (end < code_.size() && isIdentifier(code_[end])) end++;
+            std::u16string_view name = code_.substr(i, end - i);
+            bool start = start_;
+            
+            if (state_ != Declaring && state_ != Parameters) block(name);
+            
+            // G2 containers find exported functions by the lines that start with EXPORT.
+            if (name == u"EXPORT" && depth_ == 0) {
+                newline_ = lineStart_;
+                emit(name);
+                start_ = true;
+                return end;
+            }
+            
+            if (!shorten_) {
+                emit(name);
+                return end;
+            }
+            
+            /*
+             Every index below next_ that was free when reached has been
+             handed out, so finding one here means two variables now share a
+             name.
+             */
+            uint32_t index = generated(name);
+            if (index != Keep) {
+                if (index >= taken_.size()) taken_.resize(index + 1);
+                if (index < next_ && !taken_[index]) clash_ = true;
+                taken_[index] = true;
+            }
+            
+            switch (state_) {
+                case Declaring:
+                    if (peek(end) == '(') {
+                        state_ = Idle;
+                        break;
+                    }
+                    declare(name);
+                    state_ = Declared;
+                    return end;
+                    
+                case Parameters:
+                    names_.push_back({name, Keep});
+                    break;
+                    
+                default:
+                    if (name == u"LOCAL") {
+                        state_ = Declaring;
+                        break;
+                    }
+                    if (depth_ == 0 && state_ == Idle && start && peek(end) == '(') {
+                        state_ = Parameters;
+                        nesting_ = 0;
+                        break;
+                    }
+                    if (const Name* found = find(name, 0)) {
+                        rename(name, found->index);
+                        return end;
+                    }
+                    break;
+            }
+            
+            emit(name);
+            return end;
+        }
+        
+        void block(std::u16string_view name) {
+            if (name == u"BEGIN" || name == u"IF" || name == u"IFERR" || name == u"FOR" || name == u"WHILE" || name == u"REPEAT" || name == u"CASE") {
+                depth_++;
+                return;
+            }
+            
+            if ((name == u"END" || name == u"UNTIL") && depth_ > 0 && --depth_ == 0) {
+                // Leaving a function, so its names go out of scope.
+                names_.resize(global_);
+                next_ = globalNext_;
+            }
+        }
+        
+        const Name* find(std::u16string_view name, size_t from) const {
+            for (size_t i = names_.size(); i > from; --i) {
+                if (names_[i - 1].source == name) return &names_[i - 1];
+            }
+            return nullptr;
+        }
+        
+        void rename(std::u16string_view name, uint32_t index) {
+            char16_t buffer[12];
+            
+            if (index == Keep) {
+                emit(name);
+                return;
+            }
+            emit(std::u16string_view(buffer, generate(index, buffer)));
+        }
+        
+        void declare(std::u16string_view name) {
+            // Declaring a name again in the same scope refers to the same variable.
+            if (const Name* found = find(name, depth_ == 0 ? 0 : global_)) {
+                rename(name, found->index);
+                return;
+            }
+            
+            char16_t buffer[12];
+            uint32_t index = Keep;
+            
+            while (next_ < taken_.size() && taken_[next_]) next_++;
+            if (generate(next_, buffer) < name.size()) index = next_++;
+            
+            names_.push_back({name, index});
+            if (depth_ == 0) {
+                global_ = names_.size();
+                globalNext_ = next_;
+            }
+            rename(name, index);
+        }
+        
+        void punctuation(size_t i) {
+            char16_t ch = code_[i];
+            
+            emit(code_.substr(i, 1));
+            
+            switch (state_) {
+                case Declaring:
+                    state_ = Idle;
+                    break;
+                    
+                case Declared:
+                    if (ch == ',') {
+                        state_ = Declaring;
+                    } else if (ch == ':' && at(i + 1) == '=') {
+                        state_ = Initializing;
+                        nesting_ = 0;
+                    } else {
+                        state_ = Idle;
+                    }
+                    break;
+                    
+                case Initializing:
+                    if (ch == '(' || ch == '[' || ch == '{') nesting_++;
+                    if (ch == ')' || ch == ']' || ch == '}') nesting_--;
+                    if (ch == ',' && nesting_ == 0) state_ = Declaring;
+                    if (ch == ';') state_ = Idle;
+                    break;
+                    
+                case Parameters:
+                    if (ch == '(') nesting_++;
+                    if (ch == ')' && --nesting_ == 0) state_ = Idle;
+                    break;
+                    
+                default:
+                    break;
+            }
+            
+            if (ch == ';' && depth_ == 0) {
+                // A prototype's parameters end here rather than at an END.
+                if (state_ == Idle) names_.resize(global_);
+                start_ = true;
+            }
+        }
+    };
+}
+
+std::u16string minify::code(std::u16string_view code, bool shorten) {
+    Minifier minifier(code, shorten);
+    std::u16string out = minifier.run();
+    
+    // Rare enough that going over the code again beats looking ahead for every name.
+    if (minifier.clashed()) return Minifier(code, false).run();
+    return out;
+}
@@ -0,0 +1,48 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef minify_hpp
+#define minify_hpp
+
+#include <string>
+#include <string_view>
+
+namespace minify {
+    /**
+     Strips comments and every space PPL does not need from code, in one
+     pass that copies tokens straight into the result. #pragma mode lines
+     are kept as they are, and a top-level EXPORT that started a line still
+     does, so a G2 container can list the exported functions.
+     
+     With shorten set, names declared with LOCAL are also replaced by short
+     ones such as a0, b0, ... while they are in scope. EXPORTed names,
+     function names and parameters are left alone. A LOCAL that is only
+     referred to from within a string, as with EXPR, will no longer be
+     found, which is why it has to be asked for. Should the source itself
+     use a short name after it was handed out, names are left as they are.
+     */
+    std::u16string code(std::u16string_view code, bool shorten = false);
+}
+
+#endif /* minify_hpp */
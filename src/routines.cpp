@@ -0,0 +1,318 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "routines.hpp"
+#include "hpprgm.hpp"
+#include "detect.hpp"
+#include "utf.hpp"
+#include "io.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+namespace fs = std::filesystem;
+using namespace routines;
+
+static constexpr char Magic[4] = {'H', 'P', 'F', 'X'};
+static constexpr uint16_t Version = 1;
+static constexpr size_t HeaderSize = 0x28;
+static constexpr size_t RoutineSize = 16;
+
+static uint64_t get(const std::byte* p, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) value |= static_cast<uint64_t>(p[i]) << (i * 8);
+    return value;
+}
+
+static std::byte* put(std::byte* p, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) *p++ = static_cast<std::byte>(value >> (i * 8));
+    return p;
+}
+
+// MARK: - Scanning
+
+static bool isIdentifier(char16_t ch) {
+    return ch == '_' || (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+namespace {
+    /*
+     Reads UTF-16LE code units straight out of the bytes, whatever their
+     alignment, so scanning needs no decoded copy of the code.
+     */
+    class Units {
+    public:
+        explicit Units(std::span<const std::byte> code) : data_(code.data()), size_(code.size() / 2) {}
+        
+        size_t size() const { return size_; }
+        
+        char16_t operator[](size_t i) const {
+            if (i >= size_) return u'\0';
+            return static_cast<char16_t>(std::to_integer<uint16_t>(data_[i * 2]) | std::to_integer<uint16_t>(data_[i * 2 + 1]) << 8);
+        }
+        
+        bool equals(size_t at, size_t size, std::u16string_view word) const {
+            if (size != word.size()) return false;
+            for (size_t i = 0; i < size; ++i) {
+                if ((*this)[at + i] != word[i]) return false;
+            }
+            return true;
+        }
+        
+    private:
+        const std::byte* data_;
+        size_t size_;
+    };
+}
+
+static bool opensBlock(const Units& units, size_t at, size_t size) {
+    for (std::u16string_view word : {u"BEGIN", u"IF", u"IFERR", u"FOR", u"WHILE", u"REPEAT", u"CASE"}) {
+        if (units.equals(at, size, word)) return true;
+    }
+    return false;
+}
+
+static bool closesBlock(const Units& units, size_t at, size_t size) {
+    return units.equals(at, size, u"END") || units.equals(at, size, u"UNTIL");
+}
+
+std::span<const std::byte> routines::code(std::span<const std::byte> data) {
+    switch (detect::sniff(data).format) {
+        case detect::Format::G1:
+        case detect::Format::G2:
+            return hpprgm::code(data);
+            
+        case detect::Format::UTF16LE:
+            if (data[0] == std::byte{0xFF} && data[1] == std::byte{0xFE}) data = data.subspan(2);
+            return data.first(data.size() & ~size_t(1));
+            
+        default:
+            return {};
+    }
+}
+
+/*
+ Tracks BEGIN ... END nesting, skipping strings and comments, and notes
+ the first name followed by '(' in each top-level statement. A statement
+ whose BEGIN opens at the top level is a routine, ending with the END that
+ closes it and the ';' after that, if any.
+ */
+std::vector<Routine> routines::scan(std::span<const std::byte> code) {
+    constexpr size_t None = SIZE_MAX;
+    
+    Units units(code);
+    std::vector<Routine> routines;
+    int depth = 0;
+    size_t statement = None;
+    size_t name = 0;
+    size_t length = 0;
+    bool body = false;
+    size_t end = None;
+    
+    auto finish = [&](size_t at) {
+        std::u16string text(length, u'\0');
+        for (size_t i = 0; i < length; ++i) text[i] = units[name + i];
+        
+        routines.push_back({utf::utf8(text), static_cast<uint32_t>(statement * 2), static_cast<uint32_t>((at - statement) * 2)});
+        statement = end = None;
+        length = 0;
+        body = false;
+    };
+    
+    size_t i = 0;
+    while (i < units.size()) {
+        char16_t ch = units[i];
+        
+        if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+            i++;
+            continue;
+        }
+        
+        if (ch == '/' && units[i + 1] == '/') {
+            while (i < units.size() && units[i] != '\n') i++;
+            continue;
+        }
+        
+        if (end != None) {
+            if (ch == ';') {
+                finish(++i);
+                continue;
+            }
+            finish(end);
+        }
+        
+        if (depth == 0 && statement == None) statement = i;
+        size_t token = i;
+        
+        if (ch == '"') {
+            for (i++; i < units.size() && units[i] != '"'; i++) {
+                if (units[i] == '\\') i++;
+            }
+            i++;
+            continue;
+        }
+        
+        // A #pragma line stands on its own rather than starting a statement.
+        if (ch == '#' && units.equals(i, 7, u"#pragma")) {
+            while (i < units.size() && units[i] != '\n') i++;
+            if (depth == 0 && statement == token) statement = None;
+            continue;
+        }
+        
+        if (ch == '#') {
+            for (i++; isIdentifier(units[i]) || units[i] == ':'; i++) {}
+            continue;
+        }
+        
+        if (isIdentifier(ch)) {
+            while (isIdentifier(units[i])) i++;
+            
+            // Numbers, exponent and all, are read as one token and skipped.
+            if (ch >= '0' && ch <= '9') continue;
+            
+            if (opensBlock(units, token, i - token)) {
+                if (depth == 0 && length) body = true;
+                depth++;
+            } else if (closesBlock(units, token, i - token)) {
+                if (depth > 0 && --depth == 0 && body) end = i;
+            } else if (depth == 0 && length == 0) {
+                size_t next = i;
+                while (units[next] == ' ' || units[next] == '\t') next++;
+                if (units[next] == '(') {
+                    name = token;
+                    length = i - token;
+                }
+            }
+            continue;
+        }
+        
+        if (ch == ';' && depth == 0) {
+            statement = None;
+            length = 0;
+        }
+        i++;
+    }
+    
+    if (end != None) finish(end);
+    return routines;
+}
+
+// MARK: - Index
+
+const Routine* Index::find(std::string_view name) const {
+    for (const auto& routine : routines) {
+        if (routine.name == name) return &routine;
+    }
+    return nullptr;
+}
+
+fs::path routines::path(const fs::path& program) {
+    fs::path path = program;
+    
+    path += ".routines";
+    return path;
+}
+
+static std::optional<Index> load(const fs::path& path) {
+    io::MappedFile file;
+    if (!file.open(path)) return std::nullopt;
+    
+    std::span<const std::byte> data = file.bytes();
+    if (data.size() < HeaderSize || std::memcmp(data.data(), Magic, sizeof(Magic)) != 0) return std::nullopt;
+    if (get(data.data() + 4, 2) != Version) return std::nullopt;
+    
+    uint64_t count = get(data.data() + 28, 4);
+    uint64_t strings = get(data.data() + 32, 4);
+    if (HeaderSize + count * RoutineSize + strings != data.size()) return std::nullopt;
+    
+    Index index;
+    index.size = get(data.data() + 8, 8);
+    index.modified = static_cast<int64_t>(get(data.data() + 16, 8));
+    index.code = static_cast<uint32_t>(get(data.data() + 24, 4));
+    
+    const std::byte* table = data.data() + HeaderSize + count * RoutineSize;
+    for (size_t i = 0; i < count; ++i) {
+        const std::byte* p = data.data() + HeaderSize + i * RoutineSize;
+        uint64_t name = get(p + 8, 4);
+        uint64_t length = get(p + 12, 2);
+        if (name > strings || length > strings - name) return std::nullopt;
+        
+        std::string_view text(reinterpret_cast<const char*>(table + name), length);
+        index.routines.push_back({std::string(text), static_cast<uint32_t>(get(p, 4)), static_cast<uint32_t>(get(p + 4, 4))});
+    }
+    return index;
+}
+
+static bool save(const fs::path& path, const Index& index) {
+    std::string strings;
+    std::vector<std::byte> buffer(HeaderSize + index.routines.size() * RoutineSize);
+    std::byte* at = buffer.data();
+    
+    std::memcpy(at, Magic, sizeof(Magic));
+    at = put(at + 4, Version, 2);
+    at = put(at, 0, 2);
+    at = put(at, index.size, 8);
+    at = put(at, static_cast<uint64_t>(index.modified), 8);
+    at = put(at, index.code, 4);
+    at = put(at, index.routines.size(), 4);
+    std::byte* stringsSize = at;
+    at = put(at, 0, 8);
+    
+    for (const auto& routine : index.routines) {
+        size_t length = std::min<size_t>(routine.name.size(), UINT16_MAX);
+        
+        at = put(at, routine.offset, 4);
+        at = put(at, routine.size, 4);
+        at = put(at, strings.size(), 4);
+        at = put(at, length, 2);
+        at = put(at, 0, 2);
+        strings.append(routine.name, 0, length);
+    }
+    put(stringsSize, strings.size(), 4);
+    
+    return io::write(path, {std::span<const std::byte>(buffer), std::as_bytes(std::span(strings))});
+}
+
+std::optional<Index> routines::index(const fs::path& program, std::span<const std::byte> data, bool keep) {
+    std::error_code ec;
+    Index index;
+    
+    index.size = fs::file_size(program, ec);
+    if (ec) return std::nullopt;
+    auto time = fs::last_write_time(program, ec);
+    if (ec) return std::nullopt;
+    index.modified = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+    
+    auto saved = load(path(program));
+    if (saved && saved->size == index.size && saved->modified == index.modified && saved->size == data.size()) return saved;
+    
+    std::span<const std::byte> code = routines::code(data);
+    if (code.empty()) return std::nullopt;
+    
+    index.code = static_cast<uint32_t>(code.data() - data.data());
+    index.routines = scan(code);
+    if (keep) save(path(program), index);
+    return index;
+}
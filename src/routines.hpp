@@ -0,0 +1,97 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef routines_hpp
+#define routines_hpp
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+#include <filesystem>
+
+namespace routines {
+    /*
+     A routine is a top-level function definition, from its first token
+     (EXPORT, KEY or VIEW included) to the ';' after its closing END.
+     Prototypes have no body and are not routines.
+     */
+    struct Routine {
+        std::string name;
+        
+        // In bytes from the start of the UTF-16LE code.
+        uint32_t offset = 0;
+        uint32_t size = 0;
+    };
+    
+    /**
+     The UTF-16LE code of a program: the span hpprgm::code() finds in a
+     container, or a UTF-16LE .prgm file less any byte order mark. Empty for
+     anything else.
+     */
+    std::span<const std::byte> code(std::span<const std::byte> data);
+    
+    /**
+     The routines in code, in source order.
+     */
+    std::vector<Routine> scan(std::span<const std::byte> code);
+    
+    /*
+     Saved beside the program as <program>.routines, all fields little-endian:
+     
+       0x00  "HPFX", u16 version (1), u16 reserved
+       0x08  u64 size of the program, i64 modification time
+       0x18  u32 offset of the code in the program, u32 number of routines
+       0x20  u32 size of the string table, u32 reserved
+       0x28  routines, 16 bytes each, in source order:
+               u32 offset, u32 size, u32 name offset, u16 name length, u16 reserved
+             string table, UTF-8
+     */
+    
+    struct Index {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        
+        // Offset of the code in the program, which routine offsets are relative to.
+        uint32_t code = 0;
+        std::vector<Routine> routines;
+        
+        const Routine* find(std::string_view name) const;
+    };
+    
+    std::filesystem::path path(const std::filesystem::path& program);
+    
+    /**
+     The index of program, whose contents are data. A saved index is used
+     if it still matches the program's size and modification time, so the
+     code is not read at all; otherwise it is built by scanning the code,
+     and saved beside the program when keep is set.
+     */
+    std::optional<Index> index(const std::filesystem::path& program, std::span<const std::byte> data, bool keep = false);
+}
+
+#endif /* routines_hpp */
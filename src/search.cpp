@@ -0,0 +1,295 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "search.hpp"
+#include "utf.hpp"
+#include "cpu.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef CPU_X86_64
+#include <immintrin.h>
+#endif
+
+using namespace search;
+
+static char16_t unit(const std::byte* data, size_t i) {
+    return static_cast<char16_t>(std::to_integer<uint16_t>(data[i * 2]) | std::to_integer<uint16_t>(data[i * 2 + 1]) << 8);
+}
+
+static bool isIdentifier(char16_t ch) {
+    return ch == '_' || (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+// MARK: - Code Units
+
+static size_t findScalar(const std::byte* data, size_t count, char16_t ch) {
+    for (size_t i = 0; i < count; ++i) {
+        if (unit(data, i) == ch) return i;
+    }
+    return npos;
+}
+
+static size_t countScalar(const std::byte* data, size_t count, char16_t ch) {
+    size_t n = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (unit(data, i) == ch) n++;
+    }
+    return n;
+}
+
+#ifdef CPU_X86_64
+
+static size_t findSSE2(const std::byte* data, size_t count, char16_t ch) {
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(ch));
+    size_t i = 0;
+    
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+        int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(v, needle));
+        if (mask) return i + __builtin_ctz(mask) / 2;
+    }
+    size_t found = findScalar(data + i * 2, count - i, ch);
+    return found == npos ? npos : i + found;
+}
+
+static size_t countSSE2(const std::byte* data, size_t count, char16_t ch) {
+    const __m128i needle = _mm_set1_epi16(static_cast<short>(ch));
+    size_t n = 0;
+    size_t i = 0;
+    
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 2));
+        n += __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(v, needle))) / 2;
+    }
+    return n + countScalar(data + i * 2, count - i, ch);
+}
+
+__attribute__((target("avx2")))
+static size_t findAVX2(const std::byte* data, size_t count, char16_t ch) {
+    const __m256i needle = _mm256_set1_epi16(static_cast<short>(ch));
+    size_t i = 0;
+    
+    for (; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 2));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, needle)));
+        if (mask) return i + __builtin_ctz(mask) / 2;
+    }
+    size_t found = findSSE2(data + i * 2, count - i, ch);
+    return found == npos ? npos : i + found;
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t countAVX2(const std::byte* data, size_t count, char16_t ch) {
+    const __m256i needle = _mm256_set1_epi16(static_cast<short>(ch));
+    size_t n = 0;
+    size_t i = 0;
+    
+    for (; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i * 2));
+        n += __builtin_popcount(static_cast<unsigned>(_mm256_movemask_epi8(_mm256_cmpeq_epi16(v, needle)))) / 2;
+    }
+    return n + countSSE2(data + i * 2, count - i, ch);
+}
+
+#endif
+
+size_t search::find(std::span<const std::byte> data, char16_t unit, size_t from) {
+    using Find = size_t (*)(const std::byte*, size_t, char16_t);
+    
+    static const Find find = []() -> Find {
+#ifdef CPU_X86_64
+        if (cpu::avx2()) return findAVX2;
+        return findSSE2;
+#else
+        return findScalar;
+#endif
+    }();
+    
+    size_t count = data.size() / 2;
+    if (from >= count) return npos;
+    size_t found = find(data.data() + from * 2, count - from, unit);
+    return found == npos ? npos : from + found;
+}
+
+size_t search::count(std::span<const std::byte> data, char16_t unit) {
+    using Count = size_t (*)(const std::byte*, size_t, char16_t);
+    
+    static const Count count = []() -> Count {
+#ifdef CPU_X86_64
+        if (cpu::avx2()) return countAVX2;
+        return countSSE2;
+#else
+        return countScalar;
+#endif
+    }();
+    
+    return count(data.data(), data.size() / 2, unit);
+}
+
+// MARK: - Patterns
+
+namespace {
+    /*
+     What a scan needs to know about one pattern; candidates are passed to
+     verify, which does the full comparison and the word boundary check.
+     */
+    struct Scan {
+        const std::byte* data;
+        size_t count;
+        const std::byte* bytes;
+        size_t units;
+        char16_t first;
+        char16_t last;
+        size_t pattern;
+        bool words;
+        std::vector<Match>* matches;
+        
+        void verify(size_t i) const {
+            if (std::memcmp(data + i * 2, bytes, units * 2) != 0) return;
+            if (words) {
+                if (i > 0 && isIdentifier(unit(data, i - 1))) return;
+                if (i + units < count && isIdentifier(unit(data, i + units))) return;
+            }
+            matches->push_back({i, pattern});
+        }
+    };
+}
+
+static void scanScalar(const Scan& scan, size_t from) {
+    for (size_t i = from; i + scan.units <= scan.count; ++i) {
+        if (unit(scan.data, i) == scan.first && unit(scan.data, i + scan.units - 1) == scan.last) scan.verify(i);
+    }
+}
+
+#ifdef CPU_X86_64
+
+static void scanSSE2(const Scan& scan, size_t from) {
+    const __m128i first = _mm_set1_epi16(static_cast<short>(scan.first));
+    const __m128i last = _mm_set1_epi16(static_cast<short>(scan.last));
+    const std::byte* tail = scan.data + (scan.units - 1) * 2;
+    size_t i = from;
+    
+    // Two mask bits are set for every position whose first and last units both match.
+    for (; i + scan.units - 1 + 8 <= scan.count; i += 8) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(scan.data + i * 2));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tail + i * 2));
+        unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi16(a, first), _mm_cmpeq_epi16(b, last))));
+        for (; mask; mask &= mask - 1, mask &= mask - 1) scan.verify(i + __builtin_ctz(mask) / 2);
+    }
+    scanScalar(scan, i);
+}
+
+__attribute__((target("avx2")))
+static void scanAVX2(const Scan& scan, size_t from) {
+    const __m256i first = _mm256_set1_epi16(static_cast<short>(scan.first));
+    const __m256i last = _mm256_set1_epi16(static_cast<short>(scan.last));
+    const std::byte* tail = scan.data + (scan.units - 1) * 2;
+    size_t i = from;
+    
+    for (; i + scan.units - 1 + 16 <= scan.count; i += 16) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(scan.data + i * 2));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tail + i * 2));
+        unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi16(a, first), _mm256_cmpeq_epi16(b, last))));
+        for (; mask; mask &= mask - 1, mask &= mask - 1) scan.verify(i + __builtin_ctz(mask) / 2);
+    }
+    scanSSE2(scan, i);
+}
+
+#endif
+
+Matcher::Matcher(const std::vector<std::u16string>& patterns, bool words) : words_(words) {
+    for (const auto& pattern : patterns) {
+        std::vector<std::byte> bytes(2 + pattern.size() * 2);
+        bytes.resize(utf::encode(pattern, bytes.data()) - bytes.data());
+        if (bytes.empty()) continue;
+        
+        size_t units = bytes.size() / 2;
+        patterns_.push_back({bytes, unit(bytes.data(), 0), unit(bytes.data(), units - 1)});
+    }
+}
+
+std::vector<Match> Matcher::find(std::span<const std::byte> data) const {
+    using Kernel = void (*)(const Scan&, size_t);
+    
+    static const Kernel kernel = []() -> Kernel {
+#ifdef CPU_X86_64
+        if (cpu::avx2()) return scanAVX2;
+        return scanSSE2;
+#else
+        return scanScalar;
+#endif
+    }();
+    
+    std::vector<Match> matches;
+    for (size_t p = 0; p < patterns_.size(); ++p) {
+        const Pattern& pattern = patterns_[p];
+        Scan scan{
+            data.data(), data.size() / 2,
+            pattern.bytes.data(), pattern.bytes.size() / 2,
+            pattern.first, pattern.last,
+            p, words_, &matches
+        };
+        if (scan.units <= scan.count) kernel(scan, 0);
+    }
+    
+    if (patterns_.size() > 1) {
+        std::stable_sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+            return a.offset < b.offset;
+        });
+    }
+    return matches;
+}
+
+// MARK: - Lines
+
+std::vector<Line> search::grep(std::span<const std::byte> data, const Matcher& matcher) {
+    std::vector<Line> lines;
+    size_t count = data.size() / 2;
+    size_t counted = 0;
+    size_t number = 1;
+    size_t end = 0;
+    
+    for (const Match& match : matcher.find(data)) {
+        if (match.offset < end) continue;
+        
+        size_t start = match.offset;
+        while (start > 0 && unit(data.data(), start - 1) != '\n') start--;
+        number += search::count(data.subspan(counted * 2, (start - counted) * 2), '\n');
+        counted = start;
+        
+        end = search::find(data, '\n', match.offset);
+        if (end == npos) end = count;
+        
+        std::u16string text;
+        text.reserve(end - start);
+        for (size_t i = start; i < end; ++i) {
+            char16_t ch = unit(data.data(), i);
+            if (ch != '\r') text.push_back(ch);
+        }
+        lines.push_back({number, utf::utf8(text)});
+    }
+    return lines;
+}
@@ -0,0 +1,98 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef search_hpp
+#define search_hpp
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <string_view>
+
+namespace search {
+    constexpr size_t npos = static_cast<size_t>(-1);
+    
+    /*
+     Everything here works on UTF-16LE code held as raw bytes, such as the
+     span returned by hpprgm::code(), with offsets counted in code units.
+     The bytes need not be aligned.
+     */
+    
+    /**
+     Index of the first code unit equal to unit at or after from, or npos.
+     */
+    size_t find(std::span<const std::byte> data, char16_t unit, size_t from = 0);
+    
+    /**
+     Number of code units equal to unit.
+     */
+    size_t count(std::span<const std::byte> data, char16_t unit);
+    
+    struct Match {
+        size_t offset;
+        size_t pattern;
+    };
+    
+    /**
+     Finds every occurrence of any of a set of patterns. Each pattern is
+     encoded to UTF-16LE once, and candidates are found by comparing a
+     vector's worth of positions against its first and last code units at
+     a time, so only those that pass are compared in full.
+     */
+    class Matcher {
+    public:
+        /**
+         With words set, a match only counts if it is not part of a longer
+         identifier.
+         */
+        explicit Matcher(const std::vector<std::u16string>& patterns, bool words = false);
+        
+        // Matches ordered by offset.
+        std::vector<Match> find(std::span<const std::byte> data) const;
+        
+    private:
+        struct Pattern {
+            std::vector<std::byte> bytes;
+            char16_t first;
+            char16_t last;
+        };
+        
+        std::vector<Pattern> patterns_;
+        bool words_;
+    };
+    
+    struct Line {
+        size_t number;
+        std::string text;
+    };
+    
+    /**
+     The lines holding a match, numbered from 1. Only these lines are ever
+     decoded.
+     */
+    std::vector<Line> grep(std::span<const std::byte> data, const Matcher& matcher);
+}
+
+#endif /* search_hpp */
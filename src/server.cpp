@@ -0,0 +1,382 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "server.hpp"
+#include "hpprgm.hpp"
+#include "utf.hpp"
+#include "io.hpp"
+#include "threadpool.hpp"
+#include "detect.hpp"
+
+#include <cerrno>
+#include <cstring>
+
+#ifndef _WIN32
+#include <csignal>
+#include <unistd.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#endif
+
+namespace fs = std::filesystem;
+
+#ifndef _WIN32
+
+namespace {
+    /**
+     Buffers each worker keeps between requests. They grow to fit, so
+     converting the same kind of request again does not touch the heap, but
+     any that grew past RetainedSize for an unusually large program are
+     released before the worker waits for the next one.
+     */
+    struct Scratch {
+        std::string name;
+        std::vector<std::byte> input;
+        std::u16string text;
+        std::u16string program;
+        std::vector<std::byte> output;
+        std::string utf8;
+    };
+    
+    thread_local Scratch scratch;
+    
+    constexpr size_t RetainedSize = 4 * 1024 * 1024;
+    
+    /*
+     A client that goes quiet, mid-request or between requests, is dropped
+     after this long so that it cannot hold on to a worker.
+     */
+    constexpr timeval IdleTimeout = {10, 0};
+}
+
+static uint16_t u16(const std::byte* p) {
+    return static_cast<uint16_t>(p[0]) | static_cast<uint16_t>(p[1]) << 8;
+}
+
+static uint32_t u32(const std::byte* p) {
+    return static_cast<uint32_t>(u16(p)) | static_cast<uint32_t>(u16(p + 2)) << 16;
+}
+
+static void put(std::byte* p, uint32_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) p[i] = static_cast<std::byte>(value >> (i * 8));
+}
+
+template <typename T>
+static void grow(T& buffer, size_t size) {
+    if (buffer.size() < size) buffer.resize(size);
+}
+
+template <typename T>
+static void release(T& buffer) {
+    if (buffer.capacity() * sizeof(typename T::value_type) > RetainedSize) T().swap(buffer);
+}
+
+static void trim() {
+    release(scratch.input);
+    release(scratch.text);
+    release(scratch.program);
+    release(scratch.output);
+    release(scratch.utf8);
+}
+
+// MARK: - Conversion
+
+/*
+ Accepts the same inputs as the command line, told apart by the same
+ detection registry, and fails with the reason the command line would give.
+ */
+static std::string_view decode(std::span<const std::byte> input, std::u16string& text) {
+    hpprgm::Header header;
+    auto str = hpprgm::load(input, detect::sniff(input).format, header);
+    
+    if (!str) return hpprgm::describe(str.error());
+    text = std::move(*str);
+    return {};
+}
+
+static std::span<const std::byte> encode(server::Target target, std::string_view name) {
+    using server::Target;
+    
+    if (target == Target::PRGM) {
+        grow(scratch.output, 2 + scratch.text.size() * 2);
+        std::byte* end = utf::encode(scratch.text, scratch.output.data(), utf::BOMle);
+        return std::span<const std::byte>(scratch.output.data(), end);
+    }
+    
+    if (target == Target::UTF8) {
+        utf::utf8(scratch.text, scratch.utf8);
+        return std::as_bytes(std::span(scratch.utf8));
+    }
+    
+    hpprgm::Format format = target == Target::G2 ? hpprgm::G2 : hpprgm::G1;
+    utf::utf16(name, scratch.program);
+    if (scratch.program.empty()) scratch.program = u"Main";
+    
+    grow(scratch.output, hpprgm::capacity(scratch.text, format));
+    auto size = hpprgm::save(std::span(scratch.output), scratch.text, format, scratch.program);
+    if (!size) return {};
+    return std::span<const std::byte>(scratch.output.data(), *size);
+}
+
+// MARK: - Sockets
+
+static bool readAll(int fd, void* data, size_t size) {
+    auto at = static_cast<char*>(data);
+    
+    while (size) {
+        ssize_t n = ::read(fd, at, size);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        at += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+static bool writeAll(int fd, iovec* iov, int count) {
+    while (count) {
+        ssize_t n = ::writev(fd, iov, count);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) return false;
+        
+        size_t written = static_cast<size_t>(n);
+        while (count && written >= iov->iov_len) {
+            written -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count) {
+            iov->iov_base = static_cast<char*>(iov->iov_base) + written;
+            iov->iov_len -= written;
+        }
+    }
+    return true;
+}
+
+static bool respond(int fd, server::Status status, std::span<const std::byte> body) {
+    std::byte header[server::HeaderSize]{};
+    
+    put(header, static_cast<uint8_t>(status), 1);
+    put(header + 4, static_cast<uint32_t>(body.size()), 4);
+    
+    iovec iov[2] = {
+        {header, sizeof(header)},
+        {const_cast<std::byte*>(body.data()), body.size()}
+    };
+    return writeAll(fd, iov, body.empty() ? 1 : 2);
+}
+
+static bool fail(int fd, std::string_view message) {
+    return respond(fd, server::Status::Failed, std::as_bytes(std::span(message)));
+}
+
+static sockaddr_un address(const fs::path& path, bool& valid) {
+    sockaddr_un addr{};
+    
+    addr.sun_family = AF_UNIX;
+    valid = path.native().size() < sizeof(addr.sun_path);
+    if (valid) std::memcpy(addr.sun_path, path.c_str(), path.native().size());
+    return addr;
+}
+
+// MARK: - Server
+
+// Answers requests on one connection until the client closes it or goes idle.
+static void handle(int fd) {
+    std::byte header[server::HeaderSize];
+    
+    ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &IdleTimeout, sizeof(IdleTimeout));
+    ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &IdleTimeout, sizeof(IdleTimeout));
+    
+    while (true) {
+        trim();
+        if (!readAll(fd, header, sizeof(header))) return;
+        
+        auto source = static_cast<server::Source>(header[0]);
+        auto target = static_cast<server::Target>(header[1]);
+        size_t nameSize = u16(header + 2);
+        size_t payloadSize = u32(header + 4);
+        
+        if (payloadSize > server::MaximumPayload) {
+            fail(fd, "request too large");
+            return;
+        }
+        
+        grow(scratch.name, nameSize);
+        grow(scratch.input, payloadSize);
+        if (!readAll(fd, scratch.name.data(), nameSize)) return;
+        if (!readAll(fd, scratch.input.data(), payloadSize)) return;
+        
+        std::string_view name(scratch.name.data(), nameSize);
+        std::span<const std::byte> input(scratch.input.data(), payloadSize);
+        
+        if (target > server::Target::UTF8 || source > server::Source::Path) {
+            if (!fail(fd, "unknown source or target")) return;
+            continue;
+        }
+        
+        io::MappedFile file;
+        if (source == server::Source::Path) {
+            std::string_view path(reinterpret_cast<const char*>(input.data()), input.size());
+            if (!file.open(fs::path(path))) {
+                if (!fail(fd, "unable to read file")) return;
+                continue;
+            }
+            input = file.bytes();
+        }
+        
+        if (std::string_view error = decode(input, scratch.text); !error.empty()) {
+            if (!fail(fd, error)) return;
+            continue;
+        }
+        
+        std::span<const std::byte> output = encode(target, name);
+        if (output.empty()) {
+            if (!fail(fd, "unable to convert")) return;
+            continue;
+        }
+        
+        if (!respond(fd, server::Status::OK, output)) return;
+    }
+}
+
+bool server::serve(const fs::path& path, unsigned threads, std::string& error) {
+    bool valid;
+    sockaddr_un addr = address(path, valid);
+    if (!valid) {
+        error = "socket path too long";
+        return false;
+    }
+    
+    // Only a stale socket is replaced; anything else at the path is left alone.
+    struct stat st;
+    if (::lstat(path.c_str(), &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            error = "path exists and is not a socket";
+            return false;
+        }
+        ::unlink(path.c_str());
+    }
+    
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) {
+        error = std::strerror(errno);
+        return false;
+    }
+    
+    // A client that hangs up early must not take the server down with it.
+    std::signal(SIGPIPE, SIG_IGN);
+    
+    if (::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(fd, SOMAXCONN) != 0) {
+        error = std::strerror(errno);
+        ::close(fd);
+        return false;
+    }
+    
+    ThreadPool pool(threads);
+    while (true) {
+        int client = ::accept(fd, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            error = std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+        
+        pool.submit([client] {
+            handle(client);
+            trim();
+            ::close(client);
+        });
+    }
+}
+
+// MARK: - Client
+
+bool server::request(const fs::path& path, Source source, Target target, std::string_view name,
+                     std::span<const std::byte> payload, std::vector<std::byte>& response, std::string& error) {
+    bool valid;
+    sockaddr_un addr = address(path, valid);
+    std::byte header[HeaderSize];
+    
+    response.clear();
+    if (!valid || name.size() > UINT16_MAX || payload.size() > MaximumPayload) {
+        error = "invalid request";
+        return false;
+    }
+    
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+        if (fd >= 0) ::close(fd);
+        error = "unable to connect to server";
+        return false;
+    }
+    
+    put(header, static_cast<uint8_t>(source), 1);
+    put(header + 1, static_cast<uint8_t>(target), 1);
+    put(header + 2, static_cast<uint16_t>(name.size()), 2);
+    put(header + 4, static_cast<uint32_t>(payload.size()), 4);
+    
+    iovec iov[3] = {
+        {header, sizeof(header)},
+        {const_cast<char*>(name.data()), name.size()},
+        {const_cast<std::byte*>(payload.data()), payload.size()}
+    };
+    
+    bool ok = writeAll(fd, iov, 3) && readAll(fd, header, sizeof(header));
+    if (ok) {
+        response.resize(u32(header + 4));
+        ok = readAll(fd, response.data(), response.size());
+    }
+    ::close(fd);
+    
+    if (!ok) {
+        error = "connection to server lost";
+        return false;
+    }
+    
+    if (static_cast<Status>(header[0]) != Status::OK) {
+        error.assign(reinterpret_cast<const char*>(response.data()), response.size());
+        response.clear();
+        return false;
+    }
+    return true;
+}
+
+#else
+
+bool server::serve(const fs::path&, unsigned, std::string& error) {
+    error = "Unix domain sockets are not supported on this platform";
+    return false;
+}
+
+bool server::request(const fs::path&, Source, Target, std::string_view, std::span<const std::byte>, std::vector<std::byte>&, std::string& error) {
+    error = "Unix domain sockets are not supported on this platform";
+    return false;
+}
+
+#endif
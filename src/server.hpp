@@ -0,0 +1,82 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef server_hpp
+#define server_hpp
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <string_view>
+#include <filesystem>
+
+namespace server {
+    enum class Source : uint8_t {
+        Bytes = 0,  // The payload is the input itself.
+        Path = 1    // The payload is the UTF-8 path of a file the server can read.
+    };
+    
+    enum class Target : uint8_t {
+        PRGM = 0,   // UTF-16LE text with a byte order mark.
+        G1 = 1,
+        G2 = 2,
+        UTF8 = 3
+    };
+    
+    enum class Status : uint8_t {
+        OK = 0,
+        Failed = 1
+    };
+    
+    /*
+     Every field is little-endian. A connection carries any number of
+     requests, each answered in turn, until the client closes it or sends
+     nothing for 10 seconds.
+     
+       request:  u8 source, u8 target, u16 name length, u32 payload length,
+                 then the name (UTF-8, the G2 program name) and the payload.
+       response: u8 status, 3 reserved bytes, u32 length, then the converted
+                 bytes or, on failure, a UTF-8 error message.
+     */
+    constexpr size_t HeaderSize = 8;
+    constexpr size_t MaximumPayload = 256 * 1024 * 1024;
+    
+    /**
+     Listens on a Unix domain socket at path, replacing any stale socket
+     there, and serves connections on a pool of threads. Only returns if the
+     socket cannot be set up, or path is taken by something other than a
+     socket, with error saying why.
+     */
+    bool serve(const std::filesystem::path& path, unsigned threads, std::string& error);
+    
+    /**
+     Sends one request to the server at path. On success response holds the
+     converted bytes; otherwise error says why.
+     */
+    bool request(const std::filesystem::path& path, Source source, Target target, std::string_view name,
+                 std::span<const std::byte> payload, std::vector<std::byte>& response, std::string& error);
+}
+
+#endif /* server_hpp */
@@ -0,0 +1,193 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "stats.hpp"
+
+#include <chrono>
+#include <iomanip>
+
+using Clock = std::chrono::steady_clock;
+
+static bool on = false;
+static thread_local stats::Counters local;
+static thread_local int phase = -1;
+static thread_local Clock::time_point since;
+
+static const char* const names[stats::PhaseCount] = {"open", "detect", "extract", "transcode", "write"};
+
+static void charge(Clock::time_point now) {
+    if (phase < 0) return;
+    local.nanoseconds[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - since).count();
+}
+
+stats::Counters& stats::Counters::operator+=(const Counters& other) {
+    for (size_t i = 0; i < PhaseCount; ++i) nanoseconds[i] += other.nanoseconds[i];
+    bytesRead += other.bytesRead;
+    bytesWritten += other.bytesWritten;
+    codeUnits += other.codeUnits;
+    codeBytes += other.codeBytes;
+    allocations += other.allocations;
+    syscalls += other.syscalls;
+    return *this;
+}
+
+void stats::enable() {
+    on = true;
+}
+
+bool stats::enabled() {
+    return on;
+}
+
+void stats::reset() {
+    local = Counters();
+    phase = -1;
+}
+
+const stats::Counters& stats::current() {
+    return local;
+}
+
+void stats::read(size_t bytes) {
+    if (on) local.bytesRead += bytes;
+}
+
+void stats::wrote(size_t bytes) {
+    if (on) local.bytesWritten += bytes;
+}
+
+void stats::transcoded(size_t units) {
+    if (on) local.codeUnits += units;
+}
+
+void stats::code(size_t bytes) {
+    if (on) local.codeBytes = bytes;
+}
+
+void stats::allocation() {
+    if (on) local.allocations++;
+}
+
+void stats::syscall(size_t count) {
+    if (on) local.syscalls += count;
+}
+
+stats::Scope::Scope(Phase phase) : previous_(::phase), active_(on) {
+    if (!active_) return;
+    
+    Clock::time_point now = Clock::now();
+    charge(now);
+    ::phase = phase;
+    since = now;
+}
+
+stats::Scope::~Scope() {
+    if (!active_) return;
+    
+    Clock::time_point now = Clock::now();
+    charge(now);
+    phase = previous_;
+    since = now;
+}
+
+// MARK: - Reporting
+
+static void quoted(std::ostream& os, const std::string& str) {
+    os << '"';
+    for (unsigned char ch : str) {
+        if (ch == '"' || ch == '\\') {
+            os << '\\' << ch;
+        } else if (ch < 0x20) {
+            os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(ch) << std::dec << std::setfill(' ');
+        } else {
+            os << ch;
+        }
+    }
+    os << '"';
+}
+
+static double milliseconds(uint64_t nanoseconds) {
+    return nanoseconds / 1e6;
+}
+
+static void printJSON(std::ostream& os, const std::filesystem::path& path, const stats::Counters& counters) {
+    os << "{\"file\":";
+    if (path.empty()) {
+        os << "null";
+    } else {
+        quoted(os, path.string());
+    }
+    
+    os << ",\"ms\":{";
+    for (size_t i = 0; i < stats::PhaseCount; ++i) {
+        os << (i ? "," : "") << '"' << names[i] << "\":" << milliseconds(counters.nanoseconds[i]);
+    }
+    os << "}"
+       << ",\"codeBytes\":" << counters.codeBytes
+       << ",\"bytesRead\":" << counters.bytesRead
+       << ",\"bytesWritten\":" << counters.bytesWritten
+       << ",\"codeUnits\":" << counters.codeUnits
+       << ",\"allocations\":" << counters.allocations
+       << ",\"syscalls\":" << counters.syscalls
+       << "}\n";
+}
+
+void stats::print(std::ostream& os, const std::filesystem::path& path, const Counters& counters, unsigned report) {
+    std::ios::fmtflags flags = os.flags();
+    std::streamsize precision = os.precision();
+    
+    os << std::fixed << std::setprecision(3);
+    if (report & JSON) {
+        printJSON(os, path, counters);
+        os.flags(flags);
+        os.precision(precision);
+        return;
+    }
+    
+    std::string label = path.empty() ? std::string("Total") : "\"" + path.filename().string() + "\"";
+    
+    if (report & Size) {
+        os << label << " size: " << counters.codeBytes << " bytes of PPL code\n";
+    }
+    
+    if (report & Timing) {
+        os << label << " time:";
+        for (size_t i = 0; i < PhaseCount; ++i) {
+            os << (i ? ", " : " ") << names[i] << " " << milliseconds(counters.nanoseconds[i]) << " ms";
+        }
+        os << "\n";
+    }
+    
+    if (report & Counts) {
+        os << label << " counts: "
+           << counters.bytesRead << " bytes read, "
+           << counters.bytesWritten << " bytes written, "
+           << counters.codeUnits << " code units, "
+           << counters.allocations << " allocations, "
+           << counters.syscalls << " syscalls\n";
+    }
+    
+    os.flags(flags);
+    os.precision(precision);
+}
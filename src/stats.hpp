@@ -0,0 +1,106 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef stats_hpp
+#define stats_hpp
+
+#include <array>
+#include <cstdint>
+#include <cstddef>
+#include <ostream>
+#include <filesystem>
+
+namespace stats {
+    enum Phase {
+        Open,       // Opening and reading the input.
+        Detect,     // Working out what the input is.
+        Extract,    // Pulling the code out of a container.
+        Transcode,  // Converting between UTF-8 and UTF-16.
+        Write,      // Building and writing the output.
+        PhaseCount
+    };
+    
+    struct Counters {
+        std::array<uint64_t, PhaseCount> nanoseconds{};
+        uint64_t bytesRead = 0;
+        uint64_t bytesWritten = 0;
+        uint64_t codeUnits = 0;
+        uint64_t codeBytes = 0;
+        uint64_t allocations = 0;
+        uint64_t syscalls = 0;
+        
+        Counters& operator+=(const Counters& other);
+    };
+    
+    /**
+     Nothing is recorded until enable() is called, which must happen before
+     any worker threads are started. Counters are kept per thread, so a job
+     that runs start to finish on one thread can reset() them beforehand and
+     read current() afterwards.
+     */
+    void enable();
+    bool enabled();
+    void reset();
+    const Counters& current();
+    
+    void read(size_t bytes);
+    void wrote(size_t bytes);
+    void transcoded(size_t units);
+    void code(size_t bytes);
+    void allocation();
+    void syscall(size_t count = 1);
+    
+    /**
+     Charges the time until it goes out of scope to phase. Scopes nest, with
+     an inner scope pausing the outer one, so every nanosecond is counted
+     against exactly one phase.
+     */
+    class Scope {
+    public:
+        explicit Scope(Phase phase);
+        ~Scope();
+        
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+        
+    private:
+        int previous_;
+        bool active_;
+    };
+    
+    enum Report {
+        Size = 1 << 0,
+        Timing = 1 << 1,
+        Counts = 1 << 2,
+        JSON = 1 << 3
+    };
+    
+    /**
+     Writes counters for path as one line of text per report, or as a single
+     line of JSON when report includes JSON.
+     */
+    void print(std::ostream& os, const std::filesystem::path& path, const Counters& counters, unsigned report);
+}
+
+#endif /* stats_hpp */
@@ -0,0 +1,330 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "stream.hpp"
+#include "utf.hpp"
+#include "stats.hpp"
+#include "detect.hpp"
+
+#include <span>
+#include <vector>
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iostream>
+#include <fcntl.h>
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    constexpr size_t ChunkSize = 64 * 1024;
+    /**
+     A sliding window over the input. Consumed bytes are dropped from the
+     front before each refill, so the window never exceeds ChunkSize.
+     */
+    class Source {
+    public:
+#ifdef _WIN32
+        explicit Source(std::streambuf* in) : in_(in), buffer_(ChunkSize) {}
+#else
+        explicit Source(int fd) : fd_(fd), buffer_(ChunkSize) {}
+#endif
+        
+        std::span<const std::byte> data() const {
+            return {buffer_.data() + begin_, end_ - begin_};
+        }
+        
+        void consume(size_t count) {
+            begin_ += count;
+        }
+        
+        bool eof() const {
+            return eof_;
+        }
+        
+        // Reads until at least `minimum` bytes are buffered or the input ends.
+        void fill(size_t minimum = 1) {
+            if (begin_) {
+                std::memmove(buffer_.data(), buffer_.data() + begin_, end_ - begin_);
+                end_ -= begin_;
+                begin_ = 0;
+            }
+            
+            stats::Scope scope(stats::Open);
+            while (!eof_ && end_ < minimum && end_ < buffer_.size()) {
+#ifdef _WIN32
+                std::streamsize n = in_ ? in_->sgetn(reinterpret_cast<char*>(buffer_.data() + end_), buffer_.size() - end_) : -1;
+#else
+                ssize_t n = ::read(fd_, buffer_.data() + end_, buffer_.size() - end_);
+                stats::syscall();
+                if (n < 0 && errno == EINTR) continue;
+#endif
+                if (n <= 0) {
+                    eof_ = true;
+                    break;
+                }
+                end_ += static_cast<size_t>(n);
+                stats::read(static_cast<size_t>(n));
+            }
+        }
+        
+    private:
+#ifdef _WIN32
+        std::streambuf* in_;
+#else
+        int fd_;
+#endif
+        std::vector<std::byte> buffer_;
+        size_t begin_ = 0;
+        size_t end_ = 0;
+        bool eof_ = false;
+    };
+}
+
+static uint32_t u32(std::span<const std::byte> data) {
+    return  static_cast<uint32_t>(data[0])        | static_cast<uint32_t>(data[1]) << 8 |
+            static_cast<uint32_t>(data[2]) << 16  | static_cast<uint32_t>(data[3]) << 24;
+}
+
+#ifdef _WIN32
+
+/*
+ Without POSIX descriptors, the standard streams stand in for standard
+ input and output, switched to binary so nothing is made of line endings.
+ */
+static std::streambuf* standard(int fd) {
+    switch (fd) {
+        case 0:
+            _setmode(_fileno(stdin), _O_BINARY);
+            return std::cin.rdbuf();
+        case 1:
+            _setmode(_fileno(stdout), _O_BINARY);
+            return std::cout.rdbuf();
+    }
+    return nullptr;
+}
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    stats::Scope scope(stats::Write);
+    std::streambuf* out = standard(fd);
+    if (!out || out->sputn(data, static_cast<std::streamsize>(size)) != static_cast<std::streamsize>(size)) return false;
+    stats::wrote(size);
+    return out->pubsync() == 0;
+}
+
+#else
+
+static bool writeAll(int fd, const char* data, size_t size) {
+    stats::Scope scope(stats::Write);
+    while (size) {
+        ssize_t n = ::write(fd, data, size);
+        stats::syscall();
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        stats::wrote(static_cast<size_t>(n));
+        data += n;
+        size -= static_cast<size_t>(n);
+    }
+    return true;
+}
+
+#endif
+
+static bool skip(Source& source, size_t count) {
+    while (count) {
+        source.fill();
+        size_t available = std::min(count, source.data().size());
+        if (available == 0) return false;
+        source.consume(available);
+        count -= available;
+    }
+    return true;
+}
+
+static bool skipToG2Code(Source& source) {
+    while (true) {
+        source.fill(4);
+        auto data = source.data();
+        if (data.size() < 4) return false;
+        
+        size_t i = 0;
+        for (; i + 4 <= data.size(); i += 2) {
+            if (data[i] == std::byte{0x9B} && data[i + 1] == std::byte{0x00} &&
+                data[i + 2] == std::byte{0xC0} && data[i + 3] == std::byte{0x00}) {
+                source.consume(i + 4);
+                return true;
+            }
+        }
+        
+        // Keep the last unit in case it is the first half of the marker.
+        source.consume(i);
+        if (source.eof()) return false;
+    }
+}
+
+static bool transcodeUTF16(Source& source, int out, bool bigEndian) {
+    stats::Scope scope(stats::Transcode);
+    std::u16string units;
+    std::string utf8;
+    size_t total = 0;
+    
+    while (true) {
+        source.fill(2);
+        auto data = source.data();
+        size_t count = data.size() / 2;
+        if (count == 0) break;
+        
+        // Only whole units are taken, so a chunk never ends part way through one.
+        units.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            auto lo = static_cast<char16_t>(data[i * 2 + (bigEndian ? 1 : 0)]);
+            auto hi = static_cast<char16_t>(data[i * 2 + (bigEndian ? 0 : 1)]);
+            units[i] = static_cast<char16_t>(hi << 8 | lo);
+        }
+        
+        size_t length = units.find(u'\0');
+        bool terminated = length != std::u16string::npos;
+        if (!terminated) length = count;
+        
+        utf::utf8(std::u16string_view(units).substr(0, length), utf8);
+        if (!writeAll(out, utf8.data(), utf8.size())) return false;
+        
+        total += length;
+        source.consume(count * 2);
+        if (terminated || source.eof()) break;
+    }
+    
+    stats::code(total * 2);
+    return total > 0;
+}
+
+static bool copyUTF8(Source& source, int out) {
+    size_t total = 0;
+    
+    while (true) {
+        source.fill();
+        auto data = source.data();
+        if (data.empty()) break;
+        
+        if (!writeAll(out, reinterpret_cast<const char*>(data.data()), data.size())) return false;
+        total += data.size();
+        source.consume(data.size());
+    }
+    
+    stats::code(total);
+    return total > 0;
+}
+
+static bool extract(Source& source, int out) {
+    // Pipes have no length up front, so G1 is judged on its header size alone.
+    source.fill(detect::ProbeSize);
+    detect::Format format = detect::sniff(source.data(), detect::UnknownSize).format;
+    
+    switch (format) {
+        case detect::Format::UTF16LE:
+        case detect::Format::UTF16BE: {
+            bool bigEndian = format == detect::Format::UTF16BE;
+            
+            // Unless the byte order was worked out from the text itself.
+            if (source.data()[0] == std::byte{bigEndian ? uint8_t{0xFE} : uint8_t{0xFF}} &&
+                source.data()[1] == std::byte{bigEndian ? uint8_t{0xFF} : uint8_t{0xFE}}) source.consume(2);
+            return transcodeUTF16(source, out, bigEndian);
+        }
+            
+        case detect::Format::G1: {
+            // Header size, header and the 4-byte code size.
+            stats::Scope scope(stats::Extract);
+            if (!skip(source, 4 + u32(source.data()) + 4)) return false;
+            return transcodeUTF16(source, out, false);
+        }
+            
+        case detect::Format::G2: {
+            stats::Scope scope(stats::Extract);
+            if (!skipToG2Code(source)) return false;
+            return transcodeUTF16(source, out, false);
+        }
+            
+        case detect::Format::UTF8: {
+            // As with every other format, the byte order mark is not part of the text.
+            auto data = source.data();
+            if (data.size() >= 3 && data[0] == std::byte{0xEF} && data[1] == std::byte{0xBB} && data[2] == std::byte{0xBF}) source.consume(3);
+            return copyUTF8(source, out);
+        }
+            
+        case detect::Format::Unknown:
+            break;
+    }
+    
+    return false;
+}
+
+bool stream::convert(int in, int out) {
+#ifdef _WIN32
+    Source source(standard(in));
+#else
+    Source source(in);
+#endif
+    return extract(source, out);
+}
+
+bool stream::write(int out, std::u16string_view str) {
+    std::string utf8;
+    
+    utf::utf8(str, utf8);
+    return writeAll(out, utf8.data(), utf8.size());
+}
+
+#ifdef _WIN32
+
+bool stream::convert(const std::filesystem::path& inpath, int out) {
+    if (inpath == "/dev/stdin") return convert(0, out);
+    
+    std::filebuf in;
+    if (!in.open(inpath, std::ios::in | std::ios::binary)) return false;
+    
+    Source source(&in);
+    return extract(source, out);
+}
+
+#else
+
+bool stream::convert(const std::filesystem::path& inpath, int out) {
+    if (inpath == "/dev/stdin") return convert(STDIN_FILENO, out);
+    
+    int fd = ::open(inpath.c_str(), O_RDONLY | O_CLOEXEC);
+    stats::syscall();
+    if (fd < 0) return false;
+    
+    bool converted = convert(fd, out);
+    ::close(fd);
+    stats::syscall();
+    return converted;
+}
+
+#endif
@@ -0,0 +1,49 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef stream_hpp
+#define stream_hpp
+
+#include <string_view>
+#include <filesystem>
+
+namespace stream {
+    /**
+     Converts a program read from `in` to UTF-8 text written to `out`, one
+     fixed-size chunk at a time, so memory use does not grow with the input.
+     The format is sniffed from the first bytes rather than a file extension,
+     which lets both descriptors be pipes. Returns false if no PPL code was
+     found.
+     */
+    bool convert(int in, int out);
+    bool convert(const std::filesystem::path& inpath, int out);
+    
+    /**
+     Writes code already in memory to out as UTF-8, as convert() would, for
+     conversions whose stages need the whole program at once.
+     */
+    bool write(int out, std::u16string_view str);
+}
+
+#endif /* stream_hpp */
@@ -0,0 +1,354 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "symbols.hpp"
+#include "hpprgm.hpp"
+#include "utf.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <tuple>
+#include <unordered_map>
+
+namespace fs = std::filesystem;
+
+static constexpr char Magic[4] = {'H', 'P', 'S', 'X'};
+static constexpr uint16_t Version = 1;
+static constexpr size_t HeaderSize = 0x18;
+static constexpr size_t FileSize = 24;
+static constexpr size_t SymbolSize = 12;
+
+static uint64_t get(const std::byte* p, size_t size) {
+    uint64_t value = 0;
+    for (size_t i = 0; i < size; ++i) value |= static_cast<uint64_t>(p[i]) << (i * 8);
+    return value;
+}
+
+static std::byte* put(std::byte* p, uint64_t value, size_t size) {
+    for (size_t i = 0; i < size; ++i) *p++ = static_cast<std::byte>(value >> (i * 8));
+    return p;
+}
+
+// MARK: - Scanning
+
+static bool isIdentifier(char16_t ch) {
+    return ch == '_' || (ch >= '0' && ch <= '9') || (ch >= 'A' && ch <= 'Z') || (ch >= 'a' && ch <= 'z');
+}
+
+static size_t skipSpaces(std::u16string_view line, size_t i) {
+    while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) i++;
+    return i;
+}
+
+/*
+ Picks out EXPORT declarations, one per line as the calculator writes them:
+ "EXPORT name(...)" for a function, or "EXPORT a := 1, b;" for one or more
+ variables.
+ */
+static void scanExports(std::u16string_view text, std::vector<symbols::Symbol>& symbols) {
+    size_t pos = 0;
+    
+    while (pos < text.size()) {
+        size_t end = text.find(u'\n', pos);
+        if (end == std::u16string_view::npos) end = text.size();
+        
+        std::u16string_view line = text.substr(pos, end - pos);
+        pos = end + 1;
+        
+        size_t i = skipSpaces(line, 0);
+        if (line.substr(i, 6) != u"EXPORT" || (i + 6 < line.size() && isIdentifier(line[i + 6]))) continue;
+        i += 6;
+        
+        while (true) {
+            i = skipSpaces(line, i);
+            size_t first = i;
+            while (i < line.size() && isIdentifier(line[i])) i++;
+            if (i == first || (line[first] >= '0' && line[first] <= '9')) break;
+            
+            std::string name = utf::utf8(line.substr(first, i - first));
+            i = skipSpaces(line, i);
+            if (i < line.size() && line[i] == '(') {
+                symbols.push_back({name, symbols::Function});
+                break;
+            }
+            symbols.push_back({name, symbols::Variable});
+            
+            // Step over any initial value to the next name in the list.
+            int depth = 0;
+            bool quoted = false;
+            for (; i < line.size(); ++i) {
+                char16_t ch = line[i];
+                if (quoted) {
+                    if (ch == '\\') i++;
+                    if (ch == '"') quoted = false;
+                    continue;
+                }
+                if (ch == '"') quoted = true;
+                if (ch == '(' || ch == '[' || ch == '{') depth++;
+                if (ch == ')' || ch == ']' || ch == '}') depth--;
+                if (depth == 0 && (ch == ',' || ch == ';')) break;
+            }
+            if (i >= line.size() || line[i] == ';') break;
+            i++;
+        }
+    }
+}
+
+std::vector<symbols::Symbol> symbols::scan(std::span<const std::byte> data) {
+    std::vector<Symbol> symbols;
+    hpprgm::Header header;
+    
+    if (header.parse(data) && !header.entries().empty()) {
+        for (const auto& entry : header.entries()) {
+            symbols.push_back({utf::utf8(entry.name), entry.type == hpprgm::Entry::Function ? Function : Variable});
+        }
+    } else {
+        std::u16string copy;
+        std::u16string_view text;
+        std::span<const std::byte> code = hpprgm::code(data);
+        
+        if (!code.empty()) {
+            // Mapped containers keep the code 2-byte aligned, so on little-endian hosts it can be read in place.
+            if (std::endian::native == std::endian::little && reinterpret_cast<uintptr_t>(code.data()) % alignof(char16_t) == 0) {
+                text = std::u16string_view(reinterpret_cast<const char16_t*>(code.data()), code.size() / 2);
+            } else {
+                copy = utf::decode(code);
+                text = copy;
+            }
+        } else {
+            text = utf::view(data, utf::BOMle);
+            if (text.empty()) {
+                copy = utf::read(data, utf::BOMle);
+                text = copy;
+            }
+        }
+        scanExports(text, symbols);
+    }
+    
+    std::sort(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) {
+        return std::tie(a.name, a.kind) < std::tie(b.name, b.kind);
+    });
+    symbols.erase(std::unique(symbols.begin(), symbols.end(), [](const Symbol& a, const Symbol& b) {
+        return a.name == b.name && a.kind == b.kind;
+    }), symbols.end());
+    return symbols;
+}
+
+// MARK: - Index
+
+bool symbols::Index::open(const fs::path& path) {
+    files_ = symbols_ = strings_ = 0;
+    if (!file_.open(path, io::Access::Random)) return false;
+    
+    std::span<const std::byte> data = file_.bytes();
+    if (data.size() < HeaderSize || std::memcmp(data.data(), Magic, sizeof(Magic)) != 0) return false;
+    if (get(data.data() + 4, 2) != Version) return false;
+    
+    uint64_t files = get(data.data() + 8, 4);
+    uint64_t symbols = get(data.data() + 12, 4);
+    uint64_t strings = get(data.data() + 16, 4);
+    if (HeaderSize + files * FileSize + symbols * SymbolSize + strings != data.size()) return false;
+    
+    files_ = files;
+    symbols_ = symbols;
+    strings_ = strings;
+    return true;
+}
+
+std::string_view symbols::Index::string(size_t offset, size_t size) const {
+    if (offset > strings_ || size > strings_ - offset) return std::string_view();
+    
+    const std::byte* table = file_.data() + HeaderSize + files_ * FileSize + symbols_ * SymbolSize;
+    return std::string_view(reinterpret_cast<const char*>(table + offset), size);
+}
+
+symbols::File symbols::Index::file(size_t index) const {
+    const std::byte* p = file_.data() + HeaderSize + index * FileSize;
+    File file;
+    
+    file.size = get(p, 8);
+    file.modified = static_cast<int64_t>(get(p + 8, 8));
+    file.path = string(get(p + 16, 4), get(p + 20, 2));
+    return file;
+}
+
+symbols::Entry symbols::Index::symbol(size_t index) const {
+    const std::byte* p = file_.data() + HeaderSize + files_ * FileSize + index * SymbolSize;
+    Entry entry;
+    
+    entry.name = string(get(p, 4), get(p + 4, 2));
+    entry.kind = get(p + 6, 1) == Variable ? Variable : Function;
+    entry.file = static_cast<uint32_t>(get(p + 8, 4));
+    return entry;
+}
+
+// First index in [first, last) for which predicate no longer holds.
+template <typename Predicate>
+static size_t partitionPoint(size_t first, size_t last, Predicate predicate) {
+    while (first < last) {
+        size_t middle = first + (last - first) / 2;
+        if (predicate(middle)) {
+            first = middle + 1;
+        } else {
+            last = middle;
+        }
+    }
+    return first;
+}
+
+std::optional<size_t> symbols::Index::findFile(std::string_view path) const {
+    size_t i = partitionPoint(0, files_, [&](size_t i) { return file(i).path < path; });
+    if (i == files_ || file(i).path != path) return std::nullopt;
+    return i;
+}
+
+std::pair<size_t, size_t> symbols::Index::find(std::string_view name, bool prefix) const {
+    size_t first = partitionPoint(0, symbols_, [&](size_t i) { return symbol(i).name < name; });
+    size_t last = partitionPoint(first, symbols_, [&](size_t i) {
+        std::string_view other = symbol(i).name;
+        return prefix ? other.starts_with(name) : other == name;
+    });
+    return {first, last};
+}
+
+// MARK: - Building
+
+bool symbols::update(const fs::path& path, const std::vector<fs::path>& files, unsigned threads, Summary& summary) {
+    struct Scanned {
+        std::string path;
+        uint64_t size = 0;
+        int64_t modified = 0;
+        std::vector<Symbol> symbols;
+        bool read = false;
+        bool scanned = false;
+    };
+    
+    Index previous;
+    bool incremental = previous.open(path);
+    
+    // The symbols each file in the previous index had, for files that have not changed.
+    std::vector<std::vector<Symbol>> kept(previous.files());
+    for (size_t i = 0; i < previous.symbols(); ++i) {
+        Entry entry = previous.symbol(i);
+        if (entry.file < kept.size()) kept[entry.file].push_back({std::string(entry.name), entry.kind});
+    }
+    
+    std::vector<std::string> paths;
+    for (const auto& file : files) paths.push_back(fs::absolute(file).lexically_normal().string());
+    
+    // Files indexed on earlier runs stay in, checked like the rest, until they are deleted.
+    for (size_t i = 0; i < previous.files(); ++i) {
+        std::error_code ec;
+        std::string_view indexed = previous.file(i).path;
+        if (fs::exists(indexed, ec)) paths.emplace_back(indexed);
+    }
+    std::sort(paths.begin(), paths.end());
+    paths.erase(std::unique(paths.begin(), paths.end()), paths.end());
+    
+    std::vector<Scanned> scanned(paths.size());
+    {
+        ThreadPool pool(threads);
+        for (size_t i = 0; i < paths.size(); ++i) {
+            pool.submit([&, i] {
+                Scanned& file = scanned[i];
+                std::error_code ec;
+                
+                file.path = paths[i];
+                file.size = fs::file_size(file.path, ec);
+                if (ec) return;
+                auto time = fs::last_write_time(file.path, ec);
+                if (ec) return;
+                file.modified = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+                
+                auto index = incremental ? previous.findFile(file.path) : std::nullopt;
+                if (index && previous.file(*index).size == file.size && previous.file(*index).modified == file.modified) {
+                    file.symbols = kept[*index];
+                    file.read = true;
+                    return;
+                }
+                
+                io::MappedFile mapped;
+                if (!mapped.open(file.path)) return;
+                file.symbols = scan(mapped.bytes());
+                file.read = file.scanned = true;
+            });
+        }
+        pool.wait();
+    }
+    
+    std::erase_if(scanned, [](const Scanned& file) { return !file.read; });
+    
+    std::vector<std::tuple<std::string_view, uint32_t, Kind>> entries;
+    for (uint32_t i = 0; i < scanned.size(); ++i) {
+        for (const auto& symbol : scanned[i].symbols) entries.emplace_back(symbol.name, i, symbol.kind);
+    }
+    std::sort(entries.begin(), entries.end());
+    
+    // Each distinct string is stored once.
+    std::string strings;
+    std::unordered_map<std::string_view, uint32_t> offsets;
+    auto intern = [&](std::string_view str) -> uint32_t {
+        auto [it, inserted] = offsets.try_emplace(str, static_cast<uint32_t>(strings.size()));
+        if (inserted) strings += str;
+        return it->second;
+    };
+    
+    std::vector<std::byte> buffer(HeaderSize + scanned.size() * FileSize + entries.size() * SymbolSize);
+    std::byte* at = buffer.data();
+    
+    std::memcpy(at, Magic, sizeof(Magic));
+    at = put(at + 4, Version, 2);
+    at = put(at, 0, 2);
+    at = put(at, scanned.size(), 4);
+    at = put(at, entries.size(), 4);
+    std::byte* stringsSize = at;
+    at = put(at, 0, 8);
+    
+    for (const auto& file : scanned) {
+        at = put(at, file.size, 8);
+        at = put(at, static_cast<uint64_t>(file.modified), 8);
+        at = put(at, intern(file.path), 4);
+        at = put(at, std::min<size_t>(file.path.size(), UINT16_MAX), 2);
+        at = put(at, 0, 2);
+    }
+    
+    for (const auto& [name, file, kind] : entries) {
+        at = put(at, intern(name), 4);
+        at = put(at, std::min<size_t>(name.size(), UINT16_MAX), 2);
+        at = put(at, kind, 1);
+        at = put(at, 0, 1);
+        at = put(at, file, 4);
+    }
+    put(stringsSize, strings.size(), 4);
+    
+    summary.files = scanned.size();
+    summary.symbols = entries.size();
+    summary.scanned = std::count_if(scanned.begin(), scanned.end(), [](const Scanned& file) { return file.scanned; });
+    
+    // Replaced in one rename, so a concurrent --find sees the old index or the new one.
+    return io::write(path, {buffer, std::as_bytes(std::span(strings))});
+}
@@ -0,0 +1,126 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef symbols_hpp
+#define symbols_hpp
+
+#include <span>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <optional>
+#include <string_view>
+#include <filesystem>
+
+#include "io.hpp"
+
+namespace symbols {
+    enum Kind : uint8_t {
+        Function = 0,
+        Variable = 1
+    };
+    
+    struct Symbol {
+        std::string name;
+        Kind kind = Function;
+    };
+    
+    /**
+     The names a program exports. A G1 container's header entry table is
+     used when it has one; otherwise the PPL code is scanned for EXPORT
+     declarations.
+     */
+    std::vector<Symbol> scan(std::span<const std::byte> data);
+    
+    /*
+     On disk, all fields little-endian:
+     
+       0x00  "HPSX", u16 version (1), u16 reserved
+       0x08  u32 number of files, u32 number of symbols
+       0x10  u32 size of the string table, u32 reserved
+       0x18  files, 24 bytes each, sorted by path:
+               u64 size, i64 modification time, u32 path offset, u16 path length, u16 reserved
+             symbols, 12 bytes each, sorted by name and then file:
+               u32 name offset, u16 name length, u8 kind, u8 reserved, u32 file
+             string table, UTF-8
+     */
+    
+    struct File {
+        std::string_view path;
+        uint64_t size = 0;
+        int64_t modified = 0;
+    };
+    
+    struct Entry {
+        std::string_view name;
+        Kind kind = Function;
+        uint32_t file = 0;
+    };
+    
+    /**
+     A symbol index, mapped rather than loaded, so opening it costs the same
+     however large it is and a lookup is a binary search over the mapping.
+     */
+    class Index {
+    public:
+        bool open(const std::filesystem::path& path);
+        
+        size_t files() const { return files_; }
+        size_t symbols() const { return symbols_; }
+        File file(size_t index) const;
+        Entry symbol(size_t index) const;
+        std::optional<size_t> findFile(std::string_view path) const;
+        
+        /**
+         The range of symbols named name, or starting with name when prefix
+         is set.
+         */
+        std::pair<size_t, size_t> find(std::string_view name, bool prefix = false) const;
+        
+    private:
+        std::string_view string(size_t offset, size_t size) const;
+        
+        io::MappedFile file_;
+        size_t files_ = 0;
+        size_t symbols_ = 0;
+        size_t strings_ = 0;
+    };
+    
+    struct Summary {
+        size_t files = 0;
+        size_t scanned = 0;
+        size_t symbols = 0;
+    };
+    
+    /**
+     Adds files to the index at path, creating it if need be. Files already
+     in it, whether given again or not, stay in it until they are deleted;
+     those with the same size and modification time keep their symbols and
+     only the rest are scanned, on a pool of threads.
+     */
+    bool update(const std::filesystem::path& path, const std::vector<std::filesystem::path>& files, unsigned threads, Summary& summary);
+}
+
+#endif /* symbols_hpp */
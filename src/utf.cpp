@@ -23,43 +23,185 @@
 // SOFTWARE.
 
 #include "utf.hpp"
+#include "io.hpp"
+#include "cpu.hpp"
+#include "stats.hpp"
 
-std::string utf::utf8(const std::wstring& wstr) {
-    std::string utf8;
-    uint16_t utf16 = 0;
+#include <cstring>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+#ifdef CPU_X86_64
+#include <immintrin.h>
+#endif
+
+// MARK: - UTF-16 to UTF-8
 
-    for (size_t i = 0; i < wstr.size(); i++) {
-        utf16 = static_cast<uint16_t>(wstr[i]);
+/*
+ Each 16-bit code unit is encoded on its own as one to three bytes, so the
+ UTF-8 length can be worked out up front and the output written in place
+ without any reallocation.
+ */
 
+static size_t utf8LengthScalar(const char16_t* src, size_t count) {
+    size_t length = count;
+    
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t utf16 = static_cast<uint16_t>(src[i]);
+        length += (utf16 > 0x007F) + (utf16 > 0x07FF);
+    }
+    return length;
+}
+
+static char* utf8EncodeScalar(const char16_t* src, size_t count, char* dst) {
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t utf16 = static_cast<uint16_t>(src[i]);
+        
         if (utf16 <= 0x007F) {
             // 1-byte UTF-8: 0xxxxxxx
-            utf8 += static_cast<char>(utf16 & 0x7F);
+            *dst++ = static_cast<char>(utf16 & 0x7F);
         } else if (utf16 <= 0x07FF) {
             // 2-byte UTF-8: 110xxxxx 10xxxxxx
-            utf8 += static_cast<char>(0b11000000 | ((utf16 >> 6) & 0b00011111));
-            utf8 += static_cast<char>(0b10000000 | (utf16 & 0b00111111));
+            *dst++ = static_cast<char>(0b11000000 | ((utf16 >> 6) & 0b00011111));
+            *dst++ = static_cast<char>(0b10000000 | (utf16 & 0b00111111));
         } else {
             // 3-byte UTF-8: 1110xxxx 10xxxxxx 10xxxxxx
-            utf8 += static_cast<char>(0b11100000 | ((utf16 >> 12) & 0b00001111));
-            utf8 += static_cast<char>(0b10000000 | ((utf16 >> 6) & 0b00111111));
-            utf8 += static_cast<char>(0b10000000 | (utf16 & 0b00111111));
+            *dst++ = static_cast<char>(0b11100000 | ((utf16 >> 12) & 0b00001111));
+            *dst++ = static_cast<char>(0b10000000 | ((utf16 >> 6) & 0b00111111));
+            *dst++ = static_cast<char>(0b10000000 | (utf16 & 0b00111111));
         }
     }
+    return dst;
+}
 
-    return utf8;
+#ifdef CPU_X86_64
+
+static size_t utf8LengthSSE2(const char16_t* src, size_t count) {
+    const __m128i oneByte = _mm_set1_epi16(static_cast<short>(0xFF80));
+    const __m128i twoByte = _mm_set1_epi16(static_cast<short>(0xF800));
+    const __m128i zero = _mm_setzero_si128();
+    size_t length = 0;
+    size_t i = 0;
+    
+    // Two mask bits per unit for every unit that does not need the extra byte.
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        int narrow = __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, oneByte), zero)))
+                   + __builtin_popcount(_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(v, twoByte), zero)));
+        length += 24 - narrow / 2;
+    }
+    return length + utf8LengthScalar(src + i, count - i);
 }
 
+static char* utf8EncodeSSE2(const char16_t* src, size_t count, char* dst) {
+    const __m128i nonASCII = _mm_set1_epi16(static_cast<short>(0xFF80));
+    size_t i = 0;
+    
+    for (; i + 16 <= count; i += 16) {
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i + 8));
+        
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(_mm_or_si128(a, b), nonASCII), _mm_setzero_si128())) != 0xFFFF) {
+            dst = utf8EncodeScalar(src + i, 16, dst);
+            continue;
+        }
+        
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), _mm_packus_epi16(a, b));
+        dst += 16;
+    }
+    return utf8EncodeScalar(src + i, count - i, dst);
+}
+
+__attribute__((target("avx2,popcnt")))
+static size_t utf8LengthAVX2(const char16_t* src, size_t count) {
+    const __m256i oneByte = _mm256_set1_epi16(static_cast<short>(0xFF80));
+    const __m256i twoByte = _mm256_set1_epi16(static_cast<short>(0xF800));
+    const __m256i zero = _mm256_setzero_si256();
+    size_t length = 0;
+    size_t i = 0;
+    
+    for (; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        int narrow = __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(v, oneByte), zero)))
+                   + __builtin_popcount(_mm256_movemask_epi8(_mm256_cmpeq_epi16(_mm256_and_si256(v, twoByte), zero)));
+        length += 48 - narrow / 2;
+    }
+    return length + utf8LengthSSE2(src + i, count - i);
+}
 
-std::wstring utf::utf16(const std::string& str) {
-    std::wstring utf16;
+__attribute__((target("avx2")))
+static char* utf8EncodeAVX2(const char16_t* src, size_t count, char* dst) {
+    const __m256i nonASCII = _mm256_set1_epi16(static_cast<short>(0xFF80));
     size_t i = 0;
+    
+    for (; i + 32 <= count; i += 32) {
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i + 16));
+        
+        if (!_mm256_testz_si256(_mm256_or_si256(a, b), nonASCII)) {
+            dst = utf8EncodeSSE2(src + i, 32, dst);
+            continue;
+        }
+        
+        // packus works within 128-bit lanes, so restore byte order afterwards.
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(a, b), 0b11011000);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), bytes);
+        dst += 32;
+    }
+    return utf8EncodeSSE2(src + i, count - i, dst);
+}
+
+#endif
 
+void utf::utf8(std::u16string_view str, std::string& utf8) {
+    using Length = size_t (*)(const char16_t*, size_t);
+    using Encode = char* (*)(const char16_t*, size_t, char*);
+    
+    static const auto [length, encode] = []() -> std::pair<Length, Encode> {
+#ifdef CPU_X86_64
+        if (cpu::avx2()) return {utf8LengthAVX2, utf8EncodeAVX2};
+        return {utf8LengthSSE2, utf8EncodeSSE2};
+#else
+        return {utf8LengthScalar, utf8EncodeScalar};
+#endif
+    }();
+    
+    stats::Scope scope(stats::Transcode);
+    utf8.resize(length(str.data(), str.size()));
+    encode(str.data(), str.size(), utf8.data());
+    stats::transcoded(str.size());
+}
+
+std::string utf::utf8(std::u16string_view str) {
+    std::string utf8;
+    
+    utf::utf8(str, utf8);
+    return utf8;
+}
+
+
+std::u16string utf::utf16(std::string_view str) {
+    std::u16string utf16;
+    
+    utf::utf16(str, utf16);
+    return utf16;
+}
+
+void utf::utf16(std::string_view str, std::u16string& utf16) {
+    stats::Scope scope(stats::Transcode);
+    size_t i = 0;
+    
+    utf16.clear();
+    utf16.reserve(str.size());
     while (i < str.size()) {
         uint8_t byte1 = static_cast<uint8_t>(str[i]);
 
         if ((byte1 & 0b10000000) == 0) {
             // 1-byte UTF-8: 0xxxxxxx
-            utf16 += static_cast<wchar_t>(byte1);
+            utf16 += static_cast<char16_t>(byte1);
             i += 1;
         } else if ((byte1 & 0b11100000) == 0b11000000) {
             // 2-byte UTF-8: 110xxxxx 10xxxxxx
@@ -68,7 +210,7 @@ std::wstring utf::utf16(const std::string& str) {
 
             uint16_t ch = ((byte1 & 0b00011111) << 6) |
                           (byte2 & 0b00111111);
-            utf16 += static_cast<wchar_t>(ch);
+            utf16 += static_cast<char16_t>(ch);
             i += 2;
         } else if ((byte1 & 0b11110000) == 0b11100000) {
             // 3-byte UTF-8: 1110xxxx 10xxxxxx 10xxxxxx
@@ -79,7 +221,7 @@ std::wstring utf::utf16(const std::string& str) {
             uint16_t ch = ((byte1 & 0b00001111) << 12) |
                           ((byte2 & 0b00111111) << 6) |
                           (byte3 & 0b00111111);
-            utf16 += static_cast<wchar_t>(ch);
+            utf16 += static_cast<char16_t>(ch);
             i += 3;
         } else {
             // Invalid or unsupported UTF-8 sequence
@@ -87,192 +229,280 @@ std::wstring utf::utf16(const std::string& str) {
         }
     }
 
-    return utf16;
+    stats::transcoded(utf16.size());
 }
 
 
-static uint16_t convertUTF8ToUTF16(const char* str) {
-    uint8_t *utf8 = (uint8_t *)str;
-    uint16_t utf16 = *utf8;
-    
-    if ((utf8[0] & 0b11110000) == 0b11100000) {
-        utf16 = utf8[0] & 0b11111;
-        utf16 <<= 6;
-        utf16 |= utf8[1] & 0b111111;
-        utf16 <<= 6;
-        utf16 |= utf8[2] & 0b111111;
-        return utf16;
+// MARK: - Code units to UTF-16
+
+/*
+ Each byte order gets its own instantiation, so the inner loops carry no
+ per-unit test and the order is chosen once per call. Carriage returns are
+ dropped as they go so the whole program can be handed to the stream in a
+ single write.
+ */
+
+template <std::endian Order>
+static char* utf16EncodeScalar(const char16_t* src, size_t count, char* dst) {
+    for (size_t i = 0; i < count; ++i) {
+        uint16_t utf16 = static_cast<uint16_t>(src[i]);
+        if (utf16 == '\r') continue;
+        
+        if constexpr (Order != std::endian::native) utf16 = std::byteswap(utf16);
+        std::memcpy(dst, &utf16, sizeof(utf16));
+        dst += sizeof(utf16);
     }
+    return dst;
+}
+
+template <std::endian Order>
+static void utf16Decode(const std::byte* src, size_t count, std::u16string& str) {
+    str.resize(count);
+    std::memcpy(str.data(), src, count * sizeof(char16_t));
+    str.resize(std::min(str.find(u'\0'), count));
     
-    // 110xxxxx 10xxxxxx
-    if ((utf8[0] & 0b11100000) == 0b11000000) {
-        utf16 = utf8[0] & 0b11111;
-        utf16 <<= 6;
-        utf16 |= utf8[1] & 0b111111;
-        return utf16;
+    if constexpr (Order != std::endian::native) {
+        for (char16_t& ch : str) ch = static_cast<char16_t>(std::byteswap(static_cast<uint16_t>(ch)));
     }
-    
-    return utf16;
 }
 
+#ifdef CPU_X86_64
 
-std::wstring utf::read(std::ifstream& is, BOM bom) {
-    std::wstring wstr;
-    uint16_t byte_order_mark;
-    
-    is.read(reinterpret_cast<char*>(&byte_order_mark), sizeof(byte_order_mark));
+// x86 is little-endian, so only big-endian output needs swapping here.
+
+template <std::endian Order>
+static char* utf16EncodeSSE2(const char16_t* src, size_t count, char* dst) {
+    const __m128i cr = _mm_set1_epi16('\r');
+    size_t i = 0;
     
-#ifdef __BIG_ENDIAN__
-    if (bom == BOMle && byte_order_mark != 0xFFFE) {
-        utf16 = utf16 >> 8 | utf16 << 8;
-    }
-    if (bom == BOMbe && byte_order_mark != 0xFEFF) {
-        utf16 = utf16 >> 8 | utf16 << 8;
-    }
-#else
-    if (bom == BOMle && byte_order_mark != 0xFEFF) {
-        return wstr;
-    }
-    if (bom == BOMbe && byte_order_mark != 0xFFFE) {
-        return wstr;
+    for (; i + 8 <= count; i += 8) {
+        __m128i units = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        
+        if (_mm_movemask_epi8(_mm_cmpeq_epi16(units, cr))) {
+            dst = utf16EncodeScalar<Order>(src + i, 8, dst);
+            continue;
+        }
+        
+        if constexpr (Order == std::endian::big) units = _mm_or_si128(_mm_slli_epi16(units, 8), _mm_srli_epi16(units, 8));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst), units);
+        dst += 16;
     }
-#endif
+    return utf16EncodeScalar<Order>(src + i, count - i, dst);
+}
+
+template <std::endian Order>
+__attribute__((target("avx2")))
+static char* utf16EncodeAVX2(const char16_t* src, size_t count, char* dst) {
+    const __m256i cr = _mm256_set1_epi16('\r');
+    const __m256i swap = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                          1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    size_t i = 0;
     
-    while (true) {
-        char16_t ch;
-        // Read 2 bytes (UTF-16)
-        is.read(reinterpret_cast<char*>(&ch), sizeof(ch));
+    for (; i + 16 <= count; i += 16) {
+        __m256i units = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
         
-        if (!is || ch == 0x0000) {
-            break; // EOF or null terminator
+        if (_mm256_movemask_epi8(_mm256_cmpeq_epi16(units, cr))) {
+            dst = utf16EncodeSSE2<Order>(src + i, 16, dst);
+            continue;
         }
         
-        wstr += static_cast<wchar_t>(ch);
-        is.peek();
-        if (is.eof()) break;
+        if constexpr (Order == std::endian::big) units = _mm256_shuffle_epi8(units, swap);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst), units);
+        dst += 32;
     }
+    return utf16EncodeSSE2<Order>(src + i, count - i, dst);
+}
+
+#endif
+
+/*
+ The byte order mark is compared byte by byte, so its meaning does not
+ depend on the host. Without one the units are taken to be little-endian,
+ as the calculator writes them.
+ */
+static utf::BOM byteOrderMark(const std::byte* data) {
+    if (data[0] == std::byte{0xFF} && data[1] == std::byte{0xFE}) return utf::BOMle;
+    if (data[0] == std::byte{0xFE} && data[1] == std::byte{0xFF}) return utf::BOMbe;
+    return utf::BOMnone;
+}
+
+static bool accepts(std::span<const std::byte> data, utf::BOM bom) {
+    if (data.size() < 2) return false;
+    return bom == utf::BOMnone || byteOrderMark(data.data()) == bom;
+}
+
+static std::endian order(utf::BOM bom) {
+    return bom == utf::BOMbe ? std::endian::big : std::endian::little;
+}
+
+
+std::u16string utf::read(std::ifstream& is, BOM bom) {
+    std::vector<char> buffer{std::istreambuf_iterator<char>(is), std::istreambuf_iterator<char>()};
     
-    return wstr;
+    return read(std::as_bytes(std::span(buffer)), bom);
 }
 
-std::wstring utf::load(const std::filesystem::path& path, BOM bom) {
-    std::wstring wstr;
-    std::ifstream is;
+std::u16string_view utf::view(std::span<const std::byte> data, BOM bom) {
+    if (!accepts(data, bom) || order(bom) != std::endian::native) return std::u16string_view();
     
-    is.open(path, std::ios::in | std::ios::binary);
-    if(!is.is_open()) return wstr;
+    const std::byte* units = data.data() + 2;
+    if (reinterpret_cast<uintptr_t>(units) % alignof(char16_t)) return std::u16string_view();
+    
+    size_t count = (data.size() - 2) / sizeof(char16_t);
+    std::u16string_view str(reinterpret_cast<const char16_t*>(units), count);
+    
+    return str.substr(0, str.find(u'\0'));
+}
 
-    wstr = read(is, bom);
+std::u16string utf::read(std::span<const std::byte> data, BOM bom) {
+    stats::Scope scope(stats::Transcode);
     
-    is.close();
-    return wstr;
+    if (!accepts(data, bom)) return std::u16string();
+    
+    /*
+     Mapped files are page aligned and every code span sits on an even
+     offset, so in the host's byte order this is normally a straight copy
+     out of the mapping.
+     */
+    std::u16string_view borrowed = view(data, bom);
+    if (!borrowed.empty()) {
+        stats::transcoded(borrowed.size());
+        return std::u16string(borrowed);
+    }
+    
+    std::u16string str;
+    decode(data.subspan(2), str, bom);
+    stats::transcoded(str.size());
+    return str;
+}
+
+std::u16string utf::decode(std::span<const std::byte> data, BOM bom) {
+    std::u16string str;
+    
+    decode(data, str, bom);
+    return str;
+}
+
+void utf::decode(std::span<const std::byte> data, std::u16string& str, BOM bom) {
+    size_t count = data.size() / sizeof(char16_t);
+    
+    if (order(bom) == std::endian::big) {
+        utf16Decode<std::endian::big>(data.data(), count, str);
+    } else {
+        utf16Decode<std::endian::little>(data.data(), count, str);
+    }
+}
+
+std::u16string utf::load(const std::filesystem::path& path, BOM bom) {
+    io::MappedFile file(path);
+    
+    if (!file.is_open()) return std::u16string();
+    return read(file.bytes(), bom);
 }
 
 
 size_t utf::write(std::ofstream& os, const std::string& str) {
     if (str.empty()) return 0;
 
+    stats::Scope scope(stats::Write);
     os.write(str.data(), str.size());
+    stats::wrote(str.size());
     return os.tellp();
 }
 
 
-size_t utf::write(std::ofstream& os, const std::wstring& wstr, BOM bom) {
-    if (wstr.empty()) return 0;
+std::byte* utf::encode(std::u16string_view str, std::byte* dst, BOM bom) {
+    using Encode = char* (*)(const char16_t*, size_t, char*);
+    
+    static const auto [little, big] = []() -> std::pair<Encode, Encode> {
+#ifdef CPU_X86_64
+        if (cpu::avx2()) return {utf16EncodeAVX2<std::endian::little>, utf16EncodeAVX2<std::endian::big>};
+        return {utf16EncodeSSE2<std::endian::little>, utf16EncodeSSE2<std::endian::big>};
+#else
+        return {utf16EncodeScalar<std::endian::little>, utf16EncodeScalar<std::endian::big>};
+#endif
+    }();
+    
+    stats::Scope scope(stats::Transcode);
+    stats::transcoded(str.size());
     
     if (bom == BOMle) {
-        os.put(0xFF);
-        os.put(0xFE);
+        *dst++ = std::byte{0xFF};
+        *dst++ = std::byte{0xFE};
     }
     
     if (bom == BOMbe) {
-        os.put(0xFE);
-        os.put(0xFF);
+        *dst++ = std::byte{0xFE};
+        *dst++ = std::byte{0xFF};
     }
     
-    std::string str = utf8(wstr);
+    Encode encode = bom == BOMbe ? big : little;
+    char* end = encode(str.data(), str.size(), reinterpret_cast<char*>(dst));
+    return reinterpret_cast<std::byte*>(end);
+}
+
+size_t utf::write(std::ofstream& os, std::u16string_view str, BOM bom) {
+    if (str.empty()) return 0;
     
+    stats::Scope scope(stats::Write);
+    std::vector<std::byte> buffer(2 + str.size() * 2);
+    std::byte* code = buffer.data() + (bom == BOMnone ? 0 : 2);
+    std::byte* end = encode(str, buffer.data(), bom);
     
-    size_t size = 0;
-    for ( int n = 0; n < str.length(); n++, size += 2) {
-        uint8_t *ascii = (uint8_t *)&str.at(n);
-        if (str.at(n) == '\r') continue;
-        
-        // Output as UTF-16LE
-        if (*ascii >= 0x80) {
-            uint16_t utf16 = convertUTF8ToUTF16(&str.at(n));
-            
-#ifndef __LITTLE_ENDIAN__
-            if (bom == BOMle) {
-                utf16 = utf16 >> 8 | utf16 << 8;
-            }
-#else
-            if (bom == BOMbe) {
-                utf16 = utf16 >> 8 | utf16 << 8;
-            }
-#endif
-            os.write((const char *)&utf16, 2);
-            if ((*ascii & 0b11100000) == 0b11000000) n++;
-            if ((*ascii & 0b11110000) == 0b11100000) n+=2;
-            if ((*ascii & 0b11111000) == 0b11110000) n+=3;
-        } else {
-            os.put(str.at(n));
-            os.put('\0');
-        }
-    }
-    return size;
+    os.write(reinterpret_cast<const char*>(buffer.data()), end - buffer.data());
+    stats::wrote(end - buffer.data());
+    return end - code;
 }
 
 
 bool utf::save(const std::filesystem::path& path, const std::string& str) {
-    std::ofstream os;
-    
-    os.open(path, std::ios::out | std::ios::binary);
-    if(!os.is_open()) return false;
+    return io::write(path, {std::as_bytes(std::span(str))});
+}
+
+bool utf::save(const std::filesystem::path& path, std::u16string_view str, BOM bom) {
+    std::vector<std::byte> buffer(2 + str.size() * 2);
+    std::byte* end = encode(str, buffer.data(), str.empty() ? BOMnone : bom);
     
-    write(os, str);
+    return io::write(path, {std::span(buffer.data(), end)});
+}
+
+// MARK: - std::wstring compatibility
+
+std::u16string utf::toU16String(const std::wstring& wstr) {
+    std::u16string str(wstr.size(), u'\0');
     
-    os.close();
-    return true;
+    for (size_t i = 0; i < wstr.size(); ++i) {
+        str[i] = static_cast<char16_t>(wstr[i]);
+    }
+    return str;
+}
+
+std::wstring utf::toWString(std::u16string_view str) {
+    return std::wstring(str.begin(), str.end());
+}
+
+std::string utf::utf8(const std::wstring& wstr) {
+    return utf8(toU16String(wstr));
+}
+
+size_t utf::write(std::ofstream& os, const std::wstring& wstr, BOM bom) {
+    return write(os, toU16String(wstr), bom);
 }
 
 bool utf::save(const std::filesystem::path& path, const std::wstring& wstr, BOM bom) {
-    std::ofstream os;
-    
-    os.open(path, std::ios::out | std::ios::binary);
-    if(!os.is_open()) return false;
-    
-    write(os, wstr, bom);
-    
-    os.close();
-    return true;
+    return save(path, toU16String(wstr), bom);
 }
 
 utf::BOM utf::bom(std::ifstream& is) {
     if(!is.is_open()) return BOMnone;
     
-    uint16_t byte_order_mark;
+    std::byte mark[2]{};
     
-    is.read(reinterpret_cast<char*>(&byte_order_mark), sizeof(byte_order_mark));
+    is.read(reinterpret_cast<char*>(mark), sizeof(mark));
+    is.clear();
     is.seekg(std::ios_base::beg);
     
-#ifdef __BIG_ENDIAN__
-    if (byte_order_mark == 0xFFFE) {
-        return BOMle;
-    }
-    if (byte_order_mark == 0xFEFF) {
-        return BOMbe;
-    }
-#else
-    if (byte_order_mark == 0xFFFE) {
-        return BOMbe;
-    }
-    if (byte_order_mark == 0xFEFF) {
-        return BOMle;
-    }
-#endif
-    
-    return BOMnone;
+    return byteOrderMark(mark);
 }
 
 utf::BOM utf::bom(const std::filesystem::path& path) {
@@ -28,6 +28,9 @@
 #include <sstream>
 #include <fstream>
 #include <cstdlib>
+#include <span>
+#include <string>
+#include <string_view>
 #include <filesystem>
 
 namespace utf {
@@ -37,16 +40,44 @@ namespace utf {
         BOMnone
     };
     
-    std::string utf8(const std::wstring& wstr);
-    std::wstring utf16(const std::string& str);
-    std::wstring read(std::ifstream& is, BOM bom = BOMle);
-    std::wstring load(const std::filesystem::path& path, BOM bom = BOMle);
+    std::string utf8(std::u16string_view str);
+    void utf8(std::u16string_view str, std::string& utf8);
+    std::u16string utf16(std::string_view str);
+    void utf16(std::string_view str, std::u16string& utf16);
+    std::u16string read(std::ifstream& is, BOM bom = BOMle);
+    std::u16string read(std::span<const std::byte> data, BOM bom = BOMle);
+    std::u16string_view view(std::span<const std::byte> data, BOM bom = BOMle);
+    std::u16string load(const std::filesystem::path& path, BOM bom = BOMle);
+    
+    /**
+     Code units with no byte order mark, up to the first NUL. BOMbe reads
+     them as big-endian; otherwise they are little-endian.
+     */
+    std::u16string decode(std::span<const std::byte> data, BOM bom = BOMle);
+    void decode(std::span<const std::byte> data, std::u16string& str, BOM bom = BOMle);
     size_t write(std::ofstream& os, const std::string& str);
-    size_t write(std::ofstream& os, const std::wstring& wstr, BOM bom = BOMle);
+    size_t write(std::ofstream& os, std::u16string_view str, BOM bom = BOMle);
+    
+    /**
+     Encodes str as UTF-16 in the given byte order, preceded by the matching
+     byte order mark and with carriage returns dropped. dst must have room for
+     2 + str.size() * 2 bytes. Returns the end of the encoded data.
+     */
+    std::byte* encode(std::u16string_view str, std::byte* dst, BOM bom = BOMnone);
     bool save(const std::filesystem::path& path, const std::string& str);
-    bool save(const std::filesystem::path& path, const std::wstring& wstr, BOM bom = BOMle);
+    bool save(const std::filesystem::path& path, std::u16string_view str, BOM bom = BOMle);
     BOM bom(std::ifstream& is);
     BOM bom(const std::filesystem::path& path);
+    
+    /**
+     Text is held as UTF-16 code units in std::u16string. These cover callers
+     that still pass std::wstring, whose units are truncated to 16 bits.
+     */
+    std::u16string toU16String(const std::wstring& wstr);
+    std::wstring toWString(std::u16string_view str);
+    std::string utf8(const std::wstring& wstr);
+    size_t write(std::ofstream& os, const std::wstring& wstr, BOM bom = BOMle);
+    bool save(const std::filesystem::path& path, const std::wstring& wstr, BOM bom = BOMle);
 };
 
 #endif /* utf_hpp */
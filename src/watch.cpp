@@ -0,0 +1,319 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "watch.hpp"
+#include "threadpool.hpp"
+
+#include <map>
+#include <set>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <iostream>
+
+#ifdef __linux__
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/inotify.h>
+#endif
+
+namespace fs = std::filesystem;
+using Clock = std::chrono::steady_clock;
+
+static fs::path normalize(const fs::path& path) {
+    std::error_code ec;
+    fs::path normal = fs::weakly_canonical(path, ec);
+    return ec ? path : normal;
+}
+
+static fs::file_time_type modified(const fs::path& path) {
+    std::error_code ec;
+    fs::file_time_type time = fs::last_write_time(path, ec);
+    return ec ? fs::file_time_type::min() : time;
+}
+
+namespace {
+    /**
+     Hands changed files to the pool, keeping at most one conversion of any
+     file in flight.
+     */
+    class Scheduler {
+    public:
+        Scheduler(const watch::Resolve& resolve, unsigned threads, void (*report)(const batch::Result&))
+            : resolve_(resolve), report_(report), pool_(threads) {}
+        
+        void schedule(const fs::path& path) {
+            fs::path key = normalize(path);
+            std::lock_guard<std::mutex> lock(mutex_);
+            
+            /*
+             Our own writes come back as events too. Each is consumed once; a
+             file changed since we wrote it has been edited and is a source.
+             */
+            auto output = outputs_.find(key);
+            if (output != outputs_.end()) {
+                if (!output->second) return;
+                bool ours = *output->second == modified(key);
+                outputs_.erase(output);
+                if (ours) return;
+            }
+            
+            auto job = resolve_(path);
+            if (!job) return;
+            
+            // An editor may truncate the file while it is converted, which would fault a mapping.
+            job->copyInput = true;
+            
+            if (running_.contains(key)) {
+                dirty_.insert(key);
+                return;
+            }
+            running_.insert(key);
+            start(key, *job);
+        }
+        
+    private:
+        // Called with mutex_ held.
+        void start(const fs::path& key, const batch::Job& job) {
+            fs::path output = normalize(job.outpath);
+            
+            outputs_[output] = std::nullopt;
+            pool_.submit([this, key, job, output] {
+                batch::Result result = batch::convert(job);
+                std::lock_guard<std::mutex> lock(mutex_);
+                
+                if (result.success) outputs_[output] = modified(output);
+                else outputs_.erase(output);
+                
+                if (report_) report_(result);
+                if (dirty_.erase(key)) {
+                    start(key, job);
+                    return;
+                }
+                running_.erase(key);
+            });
+        }
+        
+        const watch::Resolve& resolve_;
+        void (*report_)(const batch::Result&);
+        
+        std::mutex mutex_;
+        std::set<fs::path> running_;
+        std::set<fs::path> dirty_;
+        
+        // Outputs being written, or the time they were last written at.
+        std::map<fs::path, std::optional<fs::file_time_type>> outputs_;
+        
+        // Last, so the workers stop before anything they use goes away.
+        ThreadPool pool_;
+    };
+}
+
+#ifdef __linux__
+
+namespace {
+    class Watcher {
+    public:
+        Watcher() : fd_(inotify_init1(IN_NONBLOCK | IN_CLOEXEC)) {}
+        ~Watcher() { if (fd_ >= 0) ::close(fd_); }
+        
+        int fd() const { return fd_; }
+        
+        bool add(const fs::path& path) {
+            std::error_code ec;
+            
+            if (fs::is_directory(path, ec)) return addDirectory(path, true);
+            
+            // Editors often save by renaming over the file, so watch its directory.
+            files_.insert(normalize(path));
+            fs::path parent = path.parent_path();
+            return addDirectory(parent.empty() ? fs::path(".") : parent, false);
+        }
+        
+        // Reads whatever events are waiting, adding changed files to changed.
+        bool read(std::set<fs::path>& changed) {
+            alignas(inotify_event) char buffer[16384];
+            
+            while (true) {
+                ssize_t n = ::read(fd_, buffer, sizeof(buffer));
+                if (n < 0 && errno == EINTR) continue;
+                if (n < 0) return errno == EAGAIN;
+                if (n == 0) return false;
+                
+                for (char* p = buffer; p < buffer + n; ) {
+                    auto event = reinterpret_cast<const inotify_event*>(p);
+                    p += sizeof(inotify_event) + event->len;
+                    handle(*event, changed);
+                }
+            }
+        }
+        
+    private:
+        struct Directory {
+            fs::path path;
+            bool recursive = false;
+        };
+        
+        static constexpr uint32_t Mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+        
+        bool addDirectory(const fs::path& path, bool recursive) {
+            int wd = inotify_add_watch(fd_, path.c_str(), Mask);
+            if (wd < 0) return false;
+            
+            Directory& directory = directories_[wd];
+            directory.path = path;
+            directory.recursive |= recursive;
+            if (!recursive) return true;
+            
+            std::error_code ec;
+            for (auto it = fs::directory_iterator(path, ec); it != fs::directory_iterator(); it.increment(ec)) {
+                if (ec) break;
+                if (it->is_directory(ec)) addDirectory(it->path(), true);
+            }
+            return true;
+        }
+        
+        void handle(const inotify_event& event, std::set<fs::path>& changed) {
+            if (event.mask & IN_IGNORED) {
+                directories_.erase(event.wd);
+                return;
+            }
+            
+            auto it = directories_.find(event.wd);
+            if (it == directories_.end() || event.len == 0) return;
+            
+            Directory directory = it->second;
+            fs::path path = directory.path / event.name;
+            
+            if (event.mask & IN_ISDIR) {
+                if (!directory.recursive) return;
+                
+                // A directory created or moved in may already hold programs.
+                addDirectory(path, true);
+                std::error_code ec;
+                for (auto entry = fs::recursive_directory_iterator(path, ec); entry != fs::recursive_directory_iterator(); entry.increment(ec)) {
+                    if (ec) break;
+                    if (entry->is_regular_file(ec)) changed.insert(entry->path());
+                }
+                return;
+            }
+            
+            if (!(event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO))) return;
+            if (directory.recursive || files_.contains(normalize(path))) changed.insert(path);
+        }
+        
+        int fd_;
+        std::map<int, Directory> directories_;
+        std::set<fs::path> files_;
+    };
+}
+
+bool watch::run(const std::vector<fs::path>& paths, const Resolve& resolve, unsigned threads, void (*report)(const batch::Result&), std::chrono::milliseconds debounce) {
+    Watcher watcher;
+    std::set<fs::path> changed;
+    Clock::time_point deadline;
+    
+    if (watcher.fd() < 0) return false;
+    for (const auto& path : paths) {
+        if (!watcher.add(path)) return false;
+    }
+    
+    Scheduler scheduler(resolve, threads, report);
+    
+    while (true) {
+        int timeout = -1;
+        if (!changed.empty()) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now());
+            timeout = static_cast<int>(std::max<long long>(0, remaining.count()));
+        }
+        
+        pollfd pfd{watcher.fd(), POLLIN, 0};
+        int n = ::poll(&pfd, 1, timeout);
+        if (n < 0 && errno != EINTR) return false;
+        
+        if (n > 0) {
+            if (!watcher.read(changed)) return false;
+            deadline = Clock::now() + debounce;
+            continue;
+        }
+        
+        // Quiet for a whole debounce interval, so the burst is over.
+        for (const auto& path : changed) scheduler.schedule(path);
+        changed.clear();
+    }
+}
+
+#else
+
+/*
+ Without inotify, compare modification times on each pass instead. Slower to
+ notice changes, but the debouncing and scheduling are the same.
+ */
+static void scan(const std::vector<fs::path>& paths, std::map<fs::path, fs::file_time_type>& times, std::set<fs::path>& changed) {
+    std::error_code ec;
+    
+    auto check = [&](const fs::path& path) {
+        auto time = fs::last_write_time(path, ec);
+        if (ec) return;
+        
+        auto [it, inserted] = times.try_emplace(path, time);
+        if (inserted || it->second == time) return;
+        it->second = time;
+        changed.insert(path);
+    };
+    
+    for (const auto& path : paths) {
+        if (!fs::is_directory(path, ec)) {
+            check(path);
+            continue;
+        }
+        for (auto it = fs::recursive_directory_iterator(path, ec); it != fs::recursive_directory_iterator(); it.increment(ec)) {
+            if (ec) break;
+            if (it->is_regular_file(ec)) check(it->path());
+        }
+    }
+}
+
+bool watch::run(const std::vector<fs::path>& paths, const Resolve& resolve, unsigned threads, void (*report)(const batch::Result&), std::chrono::milliseconds debounce) {
+    std::map<fs::path, fs::file_time_type> times;
+    std::set<fs::path> changed;
+    Scheduler scheduler(resolve, threads, report);
+    
+    // The first pass only records what is already there.
+    scan(paths, times, changed);
+    
+    while (true) {
+        std::this_thread::sleep_for(std::max(debounce, std::chrono::milliseconds(250)));
+        
+        size_t before = changed.size();
+        scan(paths, times, changed);
+        if (changed.size() != before) continue;
+        
+        for (const auto& path : changed) scheduler.schedule(path);
+        changed.clear();
+    }
+}
+
+#endif
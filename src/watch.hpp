@@ -0,0 +1,60 @@
+// The MIT License (MIT)
+//
+// Copyright (c) 2024-2025 Insoft.
+//
+// Created: 2026-10-15
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#ifndef watch_hpp
+#define watch_hpp
+
+#include <vector>
+#include <chrono>
+#include <optional>
+#include <functional>
+#include <filesystem>
+
+#include "batch.hpp"
+
+namespace watch {
+    /**
+     Maps a changed file to the conversion to run for it, or to nothing if
+     the file is not a program.
+     */
+    using Resolve = std::function<std::optional<batch::Job>(const std::filesystem::path& inpath)>;
+    
+    /**
+     Stays resident, reconverting files as they are written. Each path may be
+     a file or a directory, which is watched recursively, including any
+     subdirectories created later.
+     
+     Events are coalesced until no more arrive for the debounce interval and
+     then converted on a pool of threads, leaving the event loop free. A
+     file saved again while it is still being converted is converted once
+     more afterwards rather than queued repeatedly, and the outputs written
+     here never trigger conversions of their own.
+     
+     Only returns if watching cannot start, or stops working.
+     */
+    bool run(const std::vector<std::filesystem::path>& paths, const Resolve& resolve, unsigned threads, void (*report)(const batch::Result&),
+             std::chrono::milliseconds debounce = std::chrono::milliseconds(100));
+}
+
+#endif /* watch_hpp */